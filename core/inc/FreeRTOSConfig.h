@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @ingroup rtos
+ * @brief FreeRTOS kernel configuration of the RTOS build variant.
+ *
+ * Only used with RTOS_ENABLED = 1. The build then needs the kernel
+ * sources (tasks.c, list.c and queue.c), the Cortex-M3 port
+ * (portable/GCC/ARM_CM3) and their include directories. Every object
+ * is statically allocated, so no portable/MemMang heap is needed.
+ *
+ * The port takes over the SVC, PendSV and SysTick exceptions (see
+ * stm32f1xx_it.c). The HAL keeps its own tick, stepped forward after
+ * each tickless sleep, and USE_RTOS stays 0 in stm32f1xx_hal_conf.h
+ * since the HAL has no FreeRTOS locking for F1.
+ */
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include <stdint.h>
+
+extern uint32_t SystemCoreClock;
+
+uint32_t rtos_runtime_counter(void);
+void rtos_step_hal_tick(uint32_t ticks);
+#endif
+
+/* Scheduler ---------------------------------------------------------------*/
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#define configCPU_CLOCK_HZ                      (SystemCoreClock)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configMAX_PRIORITIES                    4
+#define configMINIMAL_STACK_SIZE                ((uint16_t)96)
+#define configMAX_TASK_NAME_LEN                 8
+#define configUSE_16_BIT_TICKS                  0
+#define configSTACK_DEPTH_TYPE                  uint32_t
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       0
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configUSE_TIMERS                        0
+#define configUSE_CO_ROUTINES                   0
+
+/* Low power ---------------------------------------------------------------*/
+// The port stops the SysTick and sleeps (WFI) while every task is
+// blocked for 2 ticks or more
+#define configUSE_TICKLESS_IDLE                 1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+
+/* Memory ------------------------------------------------------------------*/
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+/* Hooks and debug ---------------------------------------------------------*/
+// The idle hook reads the run time counter, so it's read within one
+// wrap (6.5 s) of its 16 bit timer while the core runs
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+#define configGENERATE_RUN_TIME_STATS           1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        rtos_runtime_counter()
+
+#define configASSERT(x)                         if ((x) == 0) { taskDISABLE_INTERRUPTS(); while (1); }
+
+// Keeps HAL_GetTick in step with the kernel tick after a tickless sleep
+#define traceINCREASE_TICK_COUNT(ticks)         rtos_step_hal_tick(ticks)
+
+/* API functions -----------------------------------------------------------*/
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_xTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_vTaskPrioritySet                0
+#define INCLUDE_uxTaskPriorityGet               0
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    1
+
+/* Interrupt priorities ----------------------------------------------------*/
+// 4 priority bits, all of them for preemption (NVIC_PRIORITYGROUP_4)
+#define configPRIO_BITS                         4
+
+// The SysTick and PendSV run at the lowest priority, as the HAL tick
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY         15
+
+// Interrupts calling FromISR functions must have this priority or a
+// lower one (a higher number), see rtos.c
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY    5
+
+#define configKERNEL_INTERRUPT_PRIORITY         (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY    (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+/* Exception handlers ------------------------------------------------------*/
+// The SysTick handler calls the port one (see rtos_tick_handler)
+#define vPortSVCHandler     SVC_Handler
+#define xPortPendSVHandler  PendSV_Handler
+
+#endif /* FREERTOS_CONFIG_H */
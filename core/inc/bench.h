@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @defgroup bench Benchmarks
+ * @brief Game engine, renderer and display flush benchmarks.
+ *
+ * Times the game step against the snake size, the collision and food
+ * placement steps, the autopilot decisions over a whole game (mean and
+ * worst case), the cell draw primitives and the display flushes,
+ * at each display SPI clock too (see @ref nokia5110_link_test), and
+ * prints one result per line with printf, as CSV or JSON, to keep
+ * track of regressions across commits.
+ *
+ * On target the unit is CPU cycles (DWT->CYCCNT) and the output goes to
+ * the SWO pin (see __io_putchar in main.c). The host simulator build
+ * uses clock_gettime and nanoseconds instead (see sim/bench_host.c).
+ *
+ * The display must be set up before (see @ref nokia5110_setup). The
+ * benchmarks draw over it.
+ *
+ * Build with BENCH_ENABLED = 1 to enable it. Otherwise @ref bench_run
+ * compiles to nothing.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED   0
+#endif
+
+/**
+ * @ingroup bench
+ * @brief Output formats.
+ *
+ * Both give the benchmark, its parameter, the metric, the value and the
+ * unit of each result.
+ */
+typedef enum {
+    BENCH_FORMAT_CSV = 0,   /**< Header line, then one line per result. */
+    BENCH_FORMAT_JSON,      /**< Array of result objects. */
+} bench_format_t;
+
+#if (BENCH_ENABLED == 1)
+
+void bench_run(bench_format_t format);
+
+#else
+
+#define bench_run(format)
+
+#endif /* BENCH_ENABLED */
+
+#endif /* BENCH_H */
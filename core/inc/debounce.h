@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @defgroup debounce Debounce
+ * @brief Bit-parallel debounce of up to 32 inputs.
+ *
+ * Each input has a 2 bits counter, stored across two words (a vertical
+ * counter), so all the inputs are debounced together with a few logic
+ * operations per sample. An input's debounced level changes after
+ * DEBOUNCE_SAMPLES samples in a row that differ from it. Any sample that
+ * matches the debounced level resets its counter. This makes the
+ * debounce time DEBOUNCE_SAMPLES times the sample period, which the
+ * caller picks.
+ *
+ * The module only works on the sampled words, so one port read can feed
+ * it, and chords show up as several bits changing in the same sample.
+ */
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+
+/**
+ * Samples in a row before a level change is accepted. Fixed by the 2 bits
+ * counters, the debounce time is tuned with the sample period instead
+ * (KEYBOARD_SAMPLE_MS).
+ */
+#define DEBOUNCE_SAMPLES    4
+
+/**
+ * @ingroup debounce
+ * @brief Debounce state.
+ */
+typedef struct {
+    uint32_t state;     /**< Debounced levels. */
+    uint32_t count0;    /**< Counter bit 0 of each input. */
+    uint32_t count1;    /**< Counter bit 1 of each input. */
+} debounce_t;
+
+void debounce_init(debounce_t* debounce, uint32_t initial);
+uint32_t debounce_update(debounce_t* debounce, uint32_t sample);
+uint8_t debounce_is_stable(const debounce_t* debounce);
+
+#endif /* DEBOUNCE_H */
@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @defgroup keyboard Keyboard
+ * @brief Interrupt driven keyboard with a key press queue.
+ *
+ * The keys (PB12 to PB15, active low) interrupt on both edges. A
+ * falling edge is a press if the pin didn't change in the previous
+ * KEYBOARD_DEBOUNCE_MS, so the bounces on press and on release are
+ * ignored without waiting for the contacts to settle.
+ *
+ * With KEYBOARD_USE_EXTI set to 0 the keys are polled instead: the main
+ * loop calls @ref keyboard_poll, which reads the port once every
+ * KEYBOARD_SAMPLE_MS and debounces the four keys together (see
+ * @ref debounce). The EXTI lines then only wake the MCU from Stop mode.
+ *
+ * Presses are queued with their time in a ring buffer with a single
+ * producer (the EXTI interrupt or the poll) and a single consumer (the
+ * main loop), so no locking is needed and quick presses between two
+ * game steps are kept in order.
+ */
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <stdint.h>
+
+/** Define as 0 to poll and debounce the keys from the main loop. */
+#ifndef KEYBOARD_USE_EXTI
+#define KEYBOARD_USE_EXTI       1
+#endif
+
+/** Queued presses, a power of two up to 128. */
+#define KEYBOARD_QUEUE_SIZE     8
+
+/** Time a key must be stable before a press (EXTI mode). */
+#define KEYBOARD_DEBOUNCE_MS    10
+
+/** Port sample period (polling mode), a press takes DEBOUNCE_SAMPLES samples. */
+#ifndef KEYBOARD_SAMPLE_MS
+#define KEYBOARD_SAMPLE_MS      5
+#endif
+
+/** Bit of a key in @ref keyboard_held. */
+#define KEYBOARD_KEY_MASK(key)  (1U << (key))
+
+/**
+ * @ingroup keyboard
+ * @brief Keyboard keys.
+ */
+typedef enum {
+    KEYBOARD_KEY_RIGHT = 0, /**< PB12. */
+    KEYBOARD_KEY_DOWN,      /**< PB13. */
+    KEYBOARD_KEY_LEFT,      /**< PB14. */
+    KEYBOARD_KEY_UP,        /**< PB15. */
+    KEYBOARD_KEYS_NR,
+} keyboard_key_t;
+
+/**
+ * @ingroup keyboard
+ * @brief Key press event.
+ */
+typedef struct {
+    uint32_t time_ms;       /**< HAL tick of the press. */
+    keyboard_key_t key;     /**< Key pressed. */
+} keyboard_event_t;
+
+void keyboard_init(void);
+void keyboard_poll(void);
+uint8_t keyboard_read(keyboard_event_t* event);
+uint8_t keyboard_pending(void);
+uint8_t keyboard_held(void);
+uint8_t keyboard_is_idle(void);
+void keyboard_clear(void);
+uint32_t keyboard_dropped(void);
+void keyboard_irq_handler(void);
+void keyboard_edge_callback(void);
+
+#endif /* KEYBOARD_H */
@@ -0,0 +1,49 @@
+/**
+ * @file
+ * @defgroup power Power manager
+ * @brief Sleep between game ticks and Stop mode on the idle screens.
+ *
+ * Sleep mode only gates the core clock, so any interrupt (the scheduler
+ * base tick, the display DMA) resumes it. Stop mode halts all the high
+ * speed clocks: the display keeps its image, and an EXTI interrupt (the
+ * keys, see @ref keyboard) wakes the MCU, which then runs from HSI until
+ * the clock configuration callback restores the HSE and the PLL.
+ *
+ * The RTC, clocked by the 32.768 kHz LSE, keeps the time in all states.
+ * Run time is taken from the DWT cycle counter, which stops while the
+ * core sleeps (unless a debugger sets DBG_SLEEP), and the Sleep time is
+ * what is left.
+ */
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/**
+ * @ingroup power
+ * @brief Power states.
+ */
+typedef enum {
+    POWER_RUN = 0,      /**< Core running. */
+    POWER_SLEEP,        /**< Core clock stopped, waiting for any interrupt. */
+    POWER_STOP,         /**< All high speed clocks stopped, waiting for an EXTI line. */
+    POWER_STATES_NR,
+} power_state_t;
+
+/**
+ * @ingroup power
+ * @brief Power manager statistics.
+ */
+typedef struct {
+    uint32_t time_ms[POWER_STATES_NR];  /**< Time spent in each state since @ref power_init. */
+    uint32_t stops;                     /**< Number of Stop mode entries. */
+    uint32_t clock_restore_us;          /**< Last clock restore time after Stop mode. */
+    uint32_t clock_restore_max_us;      /**< Longest clock restore time after Stop mode. */
+} power_stats_t;
+
+void power_init(void (*clock_restore)(void));
+void power_sleep(void);
+void power_stop(void);
+void power_get_stats(power_stats_t* stats);
+
+#endif /* POWER_H */
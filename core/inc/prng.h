@@ -0,0 +1,29 @@
+/**
+ * @file
+ * @defgroup prng Pseudo random numbers
+ * @brief Seedable xorshift32 generator.
+ *
+ * The whole state is one word in the caller's @ref prng_t, so the same
+ * seed always gives the same sequence, on target and on the host.
+ */
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdint.h>
+
+/** Seed used in place of 0, which xorshift can't leave. */
+#define PRNG_ZERO_SEED  0x2545F491
+
+/**
+ * @ingroup prng
+ * @brief Generator state.
+ */
+typedef struct {
+    uint32_t state;     /**< Never 0. */
+} prng_t;
+
+void prng_seed(prng_t* prng, uint32_t seed);
+uint32_t prng_next(prng_t* prng);
+uint32_t prng_below(prng_t* prng, uint32_t bound);
+
+#endif /* PRNG_H */
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @defgroup profile Hot path profiling
+ * @brief Section timing with the DWT cycle counter.
+ *
+ * Each section keeps its min, max and mean duration and a call count.
+ * On target the unit is CPU cycles (DWT->CYCCNT); the host simulator
+ * build uses clock_gettime and nanoseconds instead.
+ *
+ * Build with PROFILE_ENABLED = 1 to enable it. Otherwise the macros
+ * and functions compile to nothing.
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 0
+#endif
+
+/**
+ * @ingroup profile
+ * @brief Profiled sections.
+ */
+typedef enum {
+    PROFILE_SNAKE_STEP = 0,         /**< One game step. */
+    PROFILE_CHECK_COLLISION,        /**< snake_check_collision. */
+    PROFILE_DRAW_PART,              /**< snake_draw_part. */
+    PROFILE_SCREEN_UPDATE,          /**< Screen update call from the game. */
+    PROFILE_PLACE_FOOD,             /**< snake_place_food. */
+    PROFILE_AUTOPILOT,              /**< One autopilot decision. */
+    PROFILE_SECTIONS_NR,
+} profile_section_t;
+
+/**
+ * @ingroup profile
+ * @brief Section statistics.
+ */
+typedef struct {
+    uint32_t min;       /**< Shortest run. */
+    uint32_t max;       /**< Longest run. */
+    uint64_t total;     /**< Sum of all runs, mean = total / count. */
+    uint32_t count;     /**< Number of runs. */
+} profile_stats_t;
+
+#if (PROFILE_ENABLED == 1)
+
+#ifdef SIMULATOR
+uint32_t profile_now(void);
+#else
+#include "stm32f1xx_hal.h"
+
+/**
+ * @ingroup profile
+ * @brief Reads the cycle counter.
+ */
+static inline uint32_t profile_now(void) {
+    return DWT->CYCCNT;
+}
+#endif /* SIMULATOR */
+
+void profile_init(void);
+void profile_reset(void);
+void profile_record(profile_section_t section, uint32_t duration);
+void profile_get(profile_section_t section, profile_stats_t* stats);
+void profile_dump(void);
+
+/** Starts timing a section. Must be paired with @ref PROFILE_END in the same scope. */
+#define PROFILE_START(section)  uint32_t profile_start_##section = profile_now()
+/** Stops timing a section started with @ref PROFILE_START. */
+#define PROFILE_END(section)    profile_record(section, profile_now() - profile_start_##section)
+
+#else
+
+#define profile_init()
+#define profile_reset()
+#define profile_dump()
+#define PROFILE_START(section)
+#define PROFILE_END(section)
+
+#endif /* PROFILE_ENABLED */
+
+#endif /* PROFILE_H */
@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @defgroup replay Input recording and replay
+ * @brief Records the game inputs and plays them back.
+ *
+ * A game only depends on the food generator state at its start and on
+ * the keys read at each step (see @ref snake_step), so the log holds
+ * that state as its seed, followed by one entry per key read. Each
+ * entry is the step count since the previous one, times 4, plus the
+ * key, as a little endian base 128 varint: one byte for keys up to 31
+ * steps apart, two bytes up to 4095.
+ *
+ * The log holds the current game only: it restarts with the seed of
+ * each new game, so the game of a bug report, usually not the first
+ * one after boot, is never lost to a full log. The keys of the end
+ * screens aren't recorded, a played log stops on its game over screen.
+ *
+ * The log is kept in RAM. On target it can be saved to the flash page
+ * reserved as REPLAY in the linker script on each game over screen
+ * (with REPLAY_SAVE_TO_FLASH = 1) and loaded again at boot, to run the
+ * game of a bug report again or a fixed game as a performance
+ * regression trace. The simulator reads and writes it as a file.
+ */
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "keyboard.h"
+#include "snake.h"
+
+#include <stdint.h>
+
+/** Define as 1 to play the log saved in flash at boot, instead of recording. */
+#ifndef REPLAY_FROM_FLASH
+#define REPLAY_FROM_FLASH   0
+#endif
+
+/**
+ * Define as 1 to save the log to flash on each game over screen. Each
+ * save stalls the game for about 30 ms and wears the page (10k cycles),
+ * so only debug builds should.
+ */
+#ifndef REPLAY_SAVE_TO_FLASH
+#define REPLAY_SAVE_TO_FLASH    0
+#endif
+
+/** Log size, up to the 1 KB flash page minus the page header. */
+#ifndef REPLAY_LOG_SIZE
+#define REPLAY_LOG_SIZE 1016
+#endif
+
+/**
+ * @ingroup replay
+ * @brief Replay modes.
+ */
+typedef enum {
+    REPLAY_IDLE = 0,    /**< Keys read from the keyboard, not recorded. */
+    REPLAY_RECORDING,   /**< Keys read from the keyboard and recorded. */
+    REPLAY_PLAYING,     /**< Keys read from the log, then from the keyboard. */
+} replay_mode_t;
+
+/**
+ * @ingroup replay
+ * @brief Replay status.
+ */
+typedef struct {
+    replay_mode_t mode;     /**< Current mode. */
+    uint32_t seed;          /**< Food seed of the logged game. */
+    uint16_t size;          /**< Log bytes, seed included. */
+    uint16_t events;        /**< Keys of the game recorded or played so far. */
+    uint16_t overflow;      /**< Keys of the game not recorded because the log was full. */
+    uint16_t games;         /**< Games recorded, the log holds the last one. */
+    uint8_t done;           /**< All the log was played. */
+} replay_status_t;
+
+void replay_record(uint32_t seed);
+uint8_t replay_play(const uint8_t* log, uint16_t size);
+void replay_stop(void);
+uint8_t replay_is_playing(void);
+uint8_t replay_input(snake_game_t* game, keyboard_key_t* key);
+uint16_t replay_get_log(const uint8_t** log);
+void replay_get_status(replay_status_t* status);
+#ifndef SIMULATOR
+uint8_t replay_flash_save(void);
+uint8_t replay_flash_load(void);
+#endif
+
+#endif /* REPLAY_H */
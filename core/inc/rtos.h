@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @defgroup rtos RTOS
+ * @brief FreeRTOS build variant, with the game split in three tasks.
+ *
+ * - Input task (highest priority): polls and debounces the keys into
+ *   the keyboard queue. It sleeps until a key edge wakes it up (see
+ *   @ref keyboard_edge_callback), samples the keys every
+ *   KEYBOARD_SAMPLE_MS until they settle, and wakes the game task up on
+ *   a press.
+ * - Display task: presents each drawn frame when the game notifies it,
+ *   starting the DMA transfer once the previous one is done (see
+ *   @ref nokia5110_update_cplt_callback), and gives the back buffer back
+ *   to the game.
+ * - Game task (lowest priority): runs a step every 1 / SCHEDULER_STEP_HZ
+ *   with vTaskDelayUntil, reading the keyboard queue. On the game over
+ *   and win screens it blocks until a key is pressed.
+ * - Stats task (with PROFILE_ENABLED = 1, at the game priority): prints
+ *   the profiling counters and the task statistics every 10 s. The
+ *   newlib printf is stack hungry, so it gets its own stack instead of
+ *   deepening the others.
+ *
+ * The tasks talk through the keyboard queue (the input task is its
+ * producer, the game task its consumer), the frame ready notification
+ * and the frame taken semaphore. With every task blocked, the tickless
+ * idle lets the core sleep up to the next task timeout, or forever on
+ * the idle screens, instead of waking up every tick.
+ *
+ * The tasks, their stacks and the kernel objects are static, there is
+ * no heap. The stack high water marks and the run time of each task are
+ * printed with the profiling dump (see @ref rtos_dump_stats), the run
+ * time counted by TIM2, which the game tick scheduler leaves free in
+ * this variant.
+ *
+ * Build with RTOS_ENABLED = 1 and the FreeRTOS kernel sources (see
+ * FreeRTOSConfig.h). Otherwise @ref rtos_start compiles to nothing and
+ * the main loop runs the game.
+ */
+#ifndef RTOS_H
+#define RTOS_H
+
+#include "snake.h"
+
+#include <stdint.h>
+
+/** Define as 1 to run the game in FreeRTOS tasks. */
+#ifndef RTOS_ENABLED
+#define RTOS_ENABLED        0
+#endif
+
+/** Task priorities. */
+#define RTOS_INPUT_PRIORITY     3
+#define RTOS_DISPLAY_PRIORITY   2
+#define RTOS_GAME_PRIORITY      1
+#define RTOS_STATS_PRIORITY     1
+
+/**
+ * Task stack sizes (in words). The stats task stack is sized for the
+ * newlib printf (_vfprintf_r alone takes about 1 KB with its callees),
+ * with 1 KB to spare; the dump prints the high water marks to check it.
+ */
+#define RTOS_INPUT_STACK        128
+#define RTOS_DISPLAY_STACK      256
+#define RTOS_GAME_STACK         256
+#define RTOS_STATS_STACK        512
+
+/** Run time counter frequency (TIM2). */
+#define RTOS_RUNTIME_HZ         10000
+
+#if (RTOS_ENABLED == 1)
+
+void rtos_start(snake_game_t* game, snake_input_t input);
+void rtos_dump_stats(void);
+void rtos_tick_handler(void);
+uint32_t rtos_runtime_counter(void);
+void rtos_step_hal_tick(uint32_t ticks);
+
+#else
+
+#define rtos_start(game, input)
+
+#endif /* RTOS_ENABLED */
+
+#endif /* RTOS_H */
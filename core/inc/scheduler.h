@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @defgroup scheduler Game tick scheduler
+ * @brief Fixed-step game tick scheduler on TIM2.
+ *
+ * With the keys on EXTI lines (KEYBOARD_USE_EXTI), TIM2 interrupts at
+ * the step rate only, so the core wakes up once per step. Its period is
+ * a whole number of 20 us counts (7 Hz steps are 142.86 ms).
+ *
+ * With the keys polled, TIM2 interrupts at SCHEDULER_BASE_HZ to sample
+ * them (see @ref keyboard_poll). Each base tick then adds the step rate
+ * to an accumulator, and a step is due every time it reaches
+ * SCHEDULER_BASE_HZ. The remainder is kept, so rates that don't divide
+ * the base rate don't drift (7 Hz steps alternate 142 and 143 ms).
+ *
+ * Between base ticks the core sleeps (see @ref scheduler_wait).
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/** Timer interrupt rate when polling the keys, also the highest step rate. */
+#define SCHEDULER_BASE_HZ   1000
+
+/** Default game step rate. */
+#ifndef SCHEDULER_STEP_HZ
+#define SCHEDULER_STEP_HZ   10
+#endif
+
+/**
+ * @ingroup scheduler
+ * @brief Scheduler statistics.
+ *
+ * The latency is the delay from the base tick that made a step due to
+ * the start of the step. Its spread (max - min) is the step jitter.
+ */
+typedef struct {
+    uint32_t steps;             /**< Steps run. */
+    uint32_t overruns;          /**< Steps dropped because the previous one hadn't started yet. */
+    uint32_t latency_min_us;    /**< Shortest step latency. */
+    uint32_t latency_max_us;    /**< Longest step latency. */
+} scheduler_stats_t;
+
+void scheduler_init(uint16_t step_hz);
+void scheduler_set_rate(uint16_t step_hz);
+void scheduler_wait(void);
+uint8_t scheduler_step_due(void);
+uint32_t scheduler_now_us(void);
+uint32_t scheduler_timer_clock(void);
+void scheduler_get_stats(scheduler_stats_t* stats);
+void scheduler_reset_stats(void);
+void scheduler_irq_handler(void);
+
+#endif /* SCHEDULER_H */
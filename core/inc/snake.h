@@ -1,15 +1,207 @@
 /**
  * Author: thiagopereiraprado@gmail.com
- * 
+ *
  * @file
  * @defgroup snake Snake game
  * @brief Snake game
- * 
+ *
+ * The whole game state is kept in a @ref snake_game_t context owned by
+ * the caller, so several games can run side by side: on the display,
+ * each at its own origin, or headless, with no display nor timing, as
+ * fast as the CPU allows. The keys of each step come from the input
+ * given to @ref snake_step.
+ *
+ * The board geometry is set at build time: SNAKE_PART_SIZE picks the
+ * cell size and, unless given too, SNAKE_MAX_X and SNAKE_MAX_Y fill the
+ * display with it. The index types and the body ring follow, and the
+ * cell lookup tables must be generated for it (see snake_lut.h).
+ *
  */
 #ifndef SNAKE_H
 #define SNAKE_H
 
-void snake_init(void);
-void snake_update(void);
+#include "keyboard.h"
+#include "nokia5110.h"
+#include "prng.h"
+
+#include <stdint.h>
+
+/** Food placement seed of a game not seeded (see @ref snake_seed). */
+#ifndef SNAKE_DEFAULT_SEED
+#define SNAKE_DEFAULT_SEED  1
+#endif
+
+/** Cell size (in pixels), 2, 4 or 8. */
+#ifndef SNAKE_PART_SIZE
+#define SNAKE_PART_SIZE 4
+#endif
+
+/** First pixel of the cells, from the board origin. */
+#define SNAKE_X_0       2
+#define SNAKE_Y_0       2
+
+/**
+ * Board size, in cells. Defaults to the largest board filling the
+ * display: 20 x 11 with 4 pixel cells, 40 x 22 with 2 pixel cells.
+ */
+#ifndef SNAKE_MAX_X
+#define SNAKE_MAX_X     ((NOKIA5110_MAX_COL_NR - 2 * SNAKE_X_0) / SNAKE_PART_SIZE)
+#endif
+#ifndef SNAKE_MAX_Y
+#define SNAKE_MAX_Y     ((NOKIA5110_MAX_LINE_NR * 8 - 2 * SNAKE_Y_0) / SNAKE_PART_SIZE)
+#endif
+#define SNAKE_CELLS     (SNAKE_MAX_X * SNAKE_MAX_Y)
+
+/** Cell index of a game coordinate, and the coordinate of a cell index. */
+#define SNAKE_CELL(x, y)    ((y) * SNAKE_MAX_X + (x))
+#define SNAKE_CELL_X(cell)  ((cell) % SNAKE_MAX_X)
+#define SNAKE_CELL_Y(cell)  ((cell) / SNAKE_MAX_X)
+
+/**
+ * Snake body ring size, the power of two holding a snake filling the
+ * board, so the ring positions wrap with a mask (see SNAKE_RING).
+ */
+#if (SNAKE_CELLS <= 64)
+#define SNAKE_MAX_SIZE  64
+#elif (SNAKE_CELLS <= 128)
+#define SNAKE_MAX_SIZE  128
+#elif (SNAKE_CELLS <= 256)
+#define SNAKE_MAX_SIZE  256
+#elif (SNAKE_CELLS <= 512)
+#define SNAKE_MAX_SIZE  512
+#else
+#define SNAKE_MAX_SIZE  1024
+#endif
+
+/** Wraps a body ring position, also a negative one. */
+#define SNAKE_RING(pos)     ((pos) & (SNAKE_MAX_SIZE - 1))
+
+/** Board size on the display, borders included (in pixels). */
+#define SNAKE_BOARD_WIDTH   (2 * SNAKE_X_0 + SNAKE_PART_SIZE * SNAKE_MAX_X)
+#define SNAKE_BOARD_HEIGHT  (2 * SNAKE_Y_0 + SNAKE_PART_SIZE * SNAKE_MAX_Y)
+
+/**
+ * @ingroup snake
+ * @brief Cell index, wide enough to count the cells too.
+ */
+#if (SNAKE_CELLS <= UINT8_MAX)
+typedef uint8_t snake_cell_t;
+#else
+typedef uint16_t snake_cell_t;
+#endif
+
+/**
+ * @ingroup snake
+ * @brief Body ring index.
+ */
+#if (SNAKE_MAX_SIZE <= UINT8_MAX + 1)
+typedef uint8_t snake_index_t;
+#else
+typedef uint16_t snake_index_t;
+#endif
+
+/**
+ * @ingroup snake
+ * @brief Moving directions.
+ */
+typedef enum {
+    SNAKE_DIR_RIGHT = 0,    /**< Snake moving right. */
+    SNAKE_DIR_DOWN,         /**< Snake moving down. */
+    SNAKE_DIR_LEFT,         /**< Snake moving left. */
+    SNAKE_DIR_UP,           /**< Snake moving up. */
+} snake_dir_t;
+
+/**
+ * @ingroup snake
+ * @brief Game states.
+ */
+typedef enum {
+    SNAKE_STATE_PLAYING = 0,  /**< Playing the game. */
+    SNAKE_STATE_GAME_OVER,    /**< Game over! */
+    SNAKE_STATE_WIN,          /**< You win! */
+} snake_state_t;
+
+/**
+ * @ingroup snake
+ * @brief Game coordinates.
+ *
+ * The game coordinates must be inside the following range:
+ * x = (0, SNAKE_MAX_X), y = (0, SNAKE_MAX_Y)
+ */
+typedef struct {
+    uint8_t x;  /**< X coordinate (column). */
+    uint8_t y;  /**< Y coordinate (line). */
+} snake_pos_t;
+
+typedef struct snake_game snake_game_t;
+
+/**
+ * @ingroup snake
+ * @brief Game input.
+ *
+ * Called once or more at each step, until it returns 0. NULL reads the
+ * keyboard queue.
+ *
+ * Also called with a NULL key when a game ends and when a new one
+ * starts, to drop the keys queued meanwhile. The game never touches the
+ * keyboard itself, so games with their own inputs stay independent.
+ *
+ * @param game  Game, for input policies that look at the board.
+ * @param key   Output key, NULL to drop the queued keys.
+ *
+ * @return 1 if a key was read, 0 otherwise (always with a NULL key).
+ */
+typedef uint8_t (*snake_input_t)(snake_game_t* game, keyboard_key_t* key);
+
+/**
+ * @ingroup snake
+ * @brief Frame ready hook.
+ *
+ * Called instead of @ref nokia5110_present when a frame is drawn, for a
+ * caller that sends the frames from elsewhere. The game draws the next
+ * frame as soon as it returns, so the frame must have been presented.
+ *
+ * @param game  Game.
+ */
+typedef void (*snake_present_t)(snake_game_t* game);
+
+/**
+ * @ingroup snake
+ * @brief Game context.
+ *
+ * Zero initialize it, set the caller fields (origin, headless flag,
+ * input data and present hook), then seed it and start it with
+ * @ref snake_init.
+ */
+struct snake_game {
+    snake_cell_t snake[SNAKE_MAX_SIZE]; /**< Body ring of cell indexes, from head to tail. */
+    snake_pos_t food;                   /**< Food coordinates. */
+    snake_state_t state;                /**< Game state. */
+    snake_dir_t direction;              /**< Current direction. */
+    snake_dir_t last_direction;         /**< Direction of the previous step. */
+    snake_cell_t size;                  /**< Snake size, also the score. */
+    snake_index_t head;                 /**< Head position in the body ring. */
+    prng_t prng;                        /**< Food placement generator. */
+    uint32_t step;                      /**< Steps since @ref snake_seed. */
+
+    // Free cell index, kept in sync with the body ring: the first
+    // free_cell_nr entries of free_cells are the cells not covered by
+    // the snake, and free_slot gives the position of each cell in
+    // free_cells
+    snake_cell_t free_cells[SNAKE_CELLS];   /**< Free cells, then covered ones. */
+    snake_cell_t free_slot[SNAKE_CELLS];    /**< Position of each cell in free_cells. */
+    snake_cell_t free_cell_nr;              /**< Number of free cells. */
+
+    void* input_context;                /**< Input policy data. */
+    snake_present_t present;            /**< Frame ready hook, NULL to present at once. */
+    uint8_t x0;                         /**< Board left edge on the display (in pixels). */
+    uint8_t y0;                         /**< Board top edge on the display, multiple of 8. */
+    uint8_t headless;                   /**< No drawing nor keyboard queue handling. */
+};
+
+void snake_seed(snake_game_t* game, uint32_t seed);
+void snake_init(snake_game_t* game);
+void snake_step(snake_game_t* game, snake_input_t input);
+uint8_t snake_is_idle(const snake_game_t* game);
 
 #endif /* SNAKE_H */
@@ -0,0 +1,172 @@
+/**
+ * @file
+ * @ingroup snake
+ * @brief Cell lookup tables, generated by tools/gen_cell_lut.py.
+ *
+ * Do not edit, run the script again after changing the board geometry.
+ * Only included by snake.c (and bench.c), after snake.h, which sets the
+ * board geometry picking the tables.
+ */
+#ifndef SNAKE_LUT_H
+#define SNAKE_LUT_H
+
+#include "snake.h"
+
+#include <stdint.h>
+
+#if (SNAKE_MAX_X == 40) && (SNAKE_MAX_Y == 22) && (SNAKE_PART_SIZE == 2)
+
+/** Board geometry of the tables. */
+#define SNAKE_LUT_MAX_X         40
+#define SNAKE_LUT_MAX_Y         22
+#define SNAKE_LUT_PART_SIZE     2
+#define SNAKE_LUT_X_0           2
+#define SNAKE_LUT_Y_0           2
+
+// screen_buffer offset of each cell, by cell index, from the board origin
+static const uint16_t snake_lut_offset[SNAKE_LUT_MAX_X * SNAKE_LUT_MAX_Y] = {
+      2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,  32,  34,  36,  38,  40,
+     42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,  64,  66,  68,  70,  72,  74,  76,  78,  80,
+      2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,  32,  34,  36,  38,  40,
+     42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,  64,  66,  68,  70,  72,  74,  76,  78,  80,
+      2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,  32,  34,  36,  38,  40,
+     42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,  64,  66,  68,  70,  72,  74,  76,  78,  80,
+     86,  88,  90,  92,  94,  96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124,
+    126, 128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164,
+     86,  88,  90,  92,  94,  96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124,
+    126, 128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164,
+     86,  88,  90,  92,  94,  96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124,
+    126, 128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164,
+     86,  88,  90,  92,  94,  96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124,
+    126, 128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164,
+    170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190, 192, 194, 196, 198, 200, 202, 204, 206, 208,
+    210, 212, 214, 216, 218, 220, 222, 224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248,
+    170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190, 192, 194, 196, 198, 200, 202, 204, 206, 208,
+    210, 212, 214, 216, 218, 220, 222, 224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248,
+    170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190, 192, 194, 196, 198, 200, 202, 204, 206, 208,
+    210, 212, 214, 216, 218, 220, 222, 224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248,
+    170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190, 192, 194, 196, 198, 200, 202, 204, 206, 208,
+    210, 212, 214, 216, 218, 220, 222, 224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248,
+    254, 256, 258, 260, 262, 264, 266, 268, 270, 272, 274, 276, 278, 280, 282, 284, 286, 288, 290, 292,
+    294, 296, 298, 300, 302, 304, 306, 308, 310, 312, 314, 316, 318, 320, 322, 324, 326, 328, 330, 332,
+    254, 256, 258, 260, 262, 264, 266, 268, 270, 272, 274, 276, 278, 280, 282, 284, 286, 288, 290, 292,
+    294, 296, 298, 300, 302, 304, 306, 308, 310, 312, 314, 316, 318, 320, 322, 324, 326, 328, 330, 332,
+    254, 256, 258, 260, 262, 264, 266, 268, 270, 272, 274, 276, 278, 280, 282, 284, 286, 288, 290, 292,
+    294, 296, 298, 300, 302, 304, 306, 308, 310, 312, 314, 316, 318, 320, 322, 324, 326, 328, 330, 332,
+    254, 256, 258, 260, 262, 264, 266, 268, 270, 272, 274, 276, 278, 280, 282, 284, 286, 288, 290, 292,
+    294, 296, 298, 300, 302, 304, 306, 308, 310, 312, 314, 316, 318, 320, 322, 324, 326, 328, 330, 332,
+    338, 340, 342, 344, 346, 348, 350, 352, 354, 356, 358, 360, 362, 364, 366, 368, 370, 372, 374, 376,
+    378, 380, 382, 384, 386, 388, 390, 392, 394, 396, 398, 400, 402, 404, 406, 408, 410, 412, 414, 416,
+    338, 340, 342, 344, 346, 348, 350, 352, 354, 356, 358, 360, 362, 364, 366, 368, 370, 372, 374, 376,
+    378, 380, 382, 384, 386, 388, 390, 392, 394, 396, 398, 400, 402, 404, 406, 408, 410, 412, 414, 416,
+    338, 340, 342, 344, 346, 348, 350, 352, 354, 356, 358, 360, 362, 364, 366, 368, 370, 372, 374, 376,
+    378, 380, 382, 384, 386, 388, 390, 392, 394, 396, 398, 400, 402, 404, 406, 408, 410, 412, 414, 416,
+    338, 340, 342, 344, 346, 348, 350, 352, 354, 356, 358, 360, 362, 364, 366, 368, 370, 372, 374, 376,
+    378, 380, 382, 384, 386, 388, 390, 392, 394, 396, 398, 400, 402, 404, 406, 408, 410, 412, 414, 416,
+    422, 424, 426, 428, 430, 432, 434, 436, 438, 440, 442, 444, 446, 448, 450, 452, 454, 456, 458, 460,
+    462, 464, 466, 468, 470, 472, 474, 476, 478, 480, 482, 484, 486, 488, 490, 492, 494, 496, 498, 500,
+    422, 424, 426, 428, 430, 432, 434, 436, 438, 440, 442, 444, 446, 448, 450, 452, 454, 456, 458, 460,
+    462, 464, 466, 468, 470, 472, 474, 476, 478, 480, 482, 484, 486, 488, 490, 492, 494, 496, 498, 500,
+    422, 424, 426, 428, 430, 432, 434, 436, 438, 440, 442, 444, 446, 448, 450, 452, 454, 456, 458, 460,
+    462, 464, 466, 468, 470, 472, 474, 476, 478, 480, 482, 484, 486, 488, 490, 492, 494, 496, 498, 500,
+};
+
+// Pixel masks of each board line in its first and second display line
+static const uint8_t snake_lut_mask[SNAKE_LUT_MAX_Y][2] = {
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+    { 0xC0, 0x00 },
+    { 0x03, 0x00 },
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+    { 0xC0, 0x00 },
+    { 0x03, 0x00 },
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+    { 0xC0, 0x00 },
+    { 0x03, 0x00 },
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+    { 0xC0, 0x00 },
+    { 0x03, 0x00 },
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+    { 0xC0, 0x00 },
+    { 0x03, 0x00 },
+    { 0x0C, 0x00 },
+    { 0x30, 0x00 },
+};
+
+#endif
+
+#if (SNAKE_MAX_X == 20) && (SNAKE_MAX_Y == 11) && (SNAKE_PART_SIZE == 4)
+
+/** Board geometry of the tables. */
+#define SNAKE_LUT_MAX_X         20
+#define SNAKE_LUT_MAX_Y         11
+#define SNAKE_LUT_PART_SIZE     4
+#define SNAKE_LUT_X_0           2
+#define SNAKE_LUT_Y_0           2
+
+// screen_buffer offset of each cell, by cell index, from the board origin
+static const uint16_t snake_lut_offset[SNAKE_LUT_MAX_X * SNAKE_LUT_MAX_Y] = {
+      2,   6,  10,  14,  18,  22,  26,  30,  34,  38,  42,  46,  50,  54,  58,  62,  66,  70,  74,  78,
+      2,   6,  10,  14,  18,  22,  26,  30,  34,  38,  42,  46,  50,  54,  58,  62,  66,  70,  74,  78,
+     86,  90,  94,  98, 102, 106, 110, 114, 118, 122, 126, 130, 134, 138, 142, 146, 150, 154, 158, 162,
+     86,  90,  94,  98, 102, 106, 110, 114, 118, 122, 126, 130, 134, 138, 142, 146, 150, 154, 158, 162,
+    170, 174, 178, 182, 186, 190, 194, 198, 202, 206, 210, 214, 218, 222, 226, 230, 234, 238, 242, 246,
+    170, 174, 178, 182, 186, 190, 194, 198, 202, 206, 210, 214, 218, 222, 226, 230, 234, 238, 242, 246,
+    254, 258, 262, 266, 270, 274, 278, 282, 286, 290, 294, 298, 302, 306, 310, 314, 318, 322, 326, 330,
+    254, 258, 262, 266, 270, 274, 278, 282, 286, 290, 294, 298, 302, 306, 310, 314, 318, 322, 326, 330,
+    338, 342, 346, 350, 354, 358, 362, 366, 370, 374, 378, 382, 386, 390, 394, 398, 402, 406, 410, 414,
+    338, 342, 346, 350, 354, 358, 362, 366, 370, 374, 378, 382, 386, 390, 394, 398, 402, 406, 410, 414,
+    422, 426, 430, 434, 438, 442, 446, 450, 454, 458, 462, 466, 470, 474, 478, 482, 486, 490, 494, 498,
+};
+
+// Pixel masks of each board line in its first and second display line
+static const uint8_t snake_lut_mask[SNAKE_LUT_MAX_Y][2] = {
+    { 0x3C, 0x00 },
+    { 0xC0, 0x03 },
+    { 0x3C, 0x00 },
+    { 0xC0, 0x03 },
+    { 0x3C, 0x00 },
+    { 0xC0, 0x03 },
+    { 0x3C, 0x00 },
+    { 0xC0, 0x03 },
+    { 0x3C, 0x00 },
+    { 0xC0, 0x03 },
+    { 0x3C, 0x00 },
+};
+
+#endif
+
+#if (SNAKE_MAX_X == 10) && (SNAKE_MAX_Y == 5) && (SNAKE_PART_SIZE == 8)
+
+/** Board geometry of the tables. */
+#define SNAKE_LUT_MAX_X         10
+#define SNAKE_LUT_MAX_Y         5
+#define SNAKE_LUT_PART_SIZE     8
+#define SNAKE_LUT_X_0           2
+#define SNAKE_LUT_Y_0           2
+
+// screen_buffer offset of each cell, by cell index, from the board origin
+static const uint16_t snake_lut_offset[SNAKE_LUT_MAX_X * SNAKE_LUT_MAX_Y] = {
+      2,  10,  18,  26,  34,  42,  50,  58,  66,  74,
+     86,  94, 102, 110, 118, 126, 134, 142, 150, 158,
+    170, 178, 186, 194, 202, 210, 218, 226, 234, 242,
+    254, 262, 270, 278, 286, 294, 302, 310, 318, 326,
+    338, 346, 354, 362, 370, 378, 386, 394, 402, 410,
+};
+
+// Pixel masks of each board line in its first and second display line
+static const uint8_t snake_lut_mask[SNAKE_LUT_MAX_Y][2] = {
+    { 0xFC, 0x03 },
+    { 0xFC, 0x03 },
+    { 0xFC, 0x03 },
+    { 0xFC, 0x03 },
+    { 0xFC, 0x03 },
+};
+
+#endif
+
+#endif /* SNAKE_LUT_H */
@@ -0,0 +1,289 @@
+/**
+ * @file
+ * @ingroup autopilot
+ * @brief Autopilot implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "autopilot.h"
+
+#include "profile.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+// The cycle goes along the top row, then down and up the columns from
+// right to left, and back up the left column, so it needs an even
+// number of columns
+#if (SNAKE_MAX_X % 2 != 0) || (SNAKE_MAX_Y < 2)
+#error "The autopilot cycle needs an even number of columns and 2 lines at least"
+#endif
+
+// First cycle position of the left column
+#define AUTOPILOT_LEFT_START    (SNAKE_MAX_X + (SNAKE_MAX_X - 1) * (SNAKE_MAX_Y - 1))
+
+// Free cells of the cycle kept ahead of the head when taking a
+// shortcut, room for the growth while the tail catches up
+#define AUTOPILOT_SLACK         4
+
+#define AUTOPILOT_UNREACHED     UINT16_MAX
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t autopilot_cycle_index(uint16_t cell);
+static uint16_t autopilot_cycle_distance(uint16_t from, uint16_t to);
+static uint16_t autopilot_neighbour(uint16_t cell, snake_dir_t direction);
+static uint8_t autopilot_is_free(const snake_game_t* game, uint16_t cell);
+static void autopilot_search(autopilot_t* pilot, const snake_game_t* game);
+static snake_dir_t autopilot_decide(autopilot_t* pilot, const snake_game_t* game);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup autopilot
+ * @brief Gets the position of a cell in the Hamiltonian cycle.
+ *
+ * The cycle is (0, 0) to (SNAKE_MAX_X - 1, 0) on the top row, then
+ * down the odd columns and up the even ones from the last column to
+ * column 1, below the top row, and up the column 0 back to (0, 0).
+ *
+ * @param cell  Cell index.
+ *
+ * @return Position, from 0 to SNAKE_CELLS - 1.
+ */
+static uint16_t autopilot_cycle_index(uint16_t cell) {
+    uint8_t x = SNAKE_CELL_X(cell);
+    uint8_t y = SNAKE_CELL_Y(cell);
+
+    if (y == 0) {
+        return x;
+    }
+
+    if (x == 0) {
+        return AUTOPILOT_LEFT_START + (SNAKE_MAX_Y - 1 - y);
+    }
+
+    uint16_t column_start = SNAKE_MAX_X + (SNAKE_MAX_X - 1 - x) * (SNAKE_MAX_Y - 1);
+
+    if (x % 2 == 1) {
+        return column_start + (y - 1);
+    }
+
+    return column_start + (SNAKE_MAX_Y - 1 - y);
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Counts the cycle moves from a position to another.
+ */
+static uint16_t autopilot_cycle_distance(uint16_t from, uint16_t to) {
+    return (to >= from) ? (to - from) : (to + SNAKE_CELLS - from);
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Gets the neighbour cell, wrapping around the board edges as
+ * the game does.
+ */
+static uint16_t autopilot_neighbour(uint16_t cell, snake_dir_t direction) {
+    uint8_t x = SNAKE_CELL_X(cell);
+    uint8_t y = SNAKE_CELL_Y(cell);
+
+    switch (direction) {
+        case SNAKE_DIR_RIGHT:
+            x = (x == SNAKE_MAX_X - 1) ? 0 : x + 1;
+        break;
+        case SNAKE_DIR_DOWN:
+            y = (y == SNAKE_MAX_Y - 1) ? 0 : y + 1;
+        break;
+        case SNAKE_DIR_LEFT:
+            x = (x == 0) ? SNAKE_MAX_X - 1 : x - 1;
+        break;
+        case SNAKE_DIR_UP:
+            y = (y == 0) ? SNAKE_MAX_Y - 1 : y - 1;
+        break;
+    }
+
+    return SNAKE_CELL(x, y);
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Checks if a cell isn't covered by the snake.
+ */
+static uint8_t autopilot_is_free(const snake_game_t* game, uint16_t cell) {
+    return (game->free_slot[cell] < game->free_cell_nr);
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Gets the distance of every free cell to the food.
+ *
+ * Breadth first search from the food over the free cells. The queue
+ * holds each cell at most once, so it never overflows.
+ *
+ * @param pilot Autopilot, the distances are left in pilot->distance.
+ * @param game  Game.
+ */
+static void autopilot_search(autopilot_t* pilot, const snake_game_t* game) {
+    uint16_t food = SNAKE_CELL(game->food.x, game->food.y);
+    uint16_t read = 0;
+    uint16_t write = 0;
+
+    for (uint16_t i = 0; i < SNAKE_CELLS; i++) {
+        pilot->distance[i] = AUTOPILOT_UNREACHED;
+    }
+
+    pilot->distance[food] = 0;
+    pilot->queue[write++] = food;
+
+    while (read < write) {
+        uint16_t cell = pilot->queue[read++];
+
+        for (uint8_t direction = SNAKE_DIR_RIGHT; direction <= SNAKE_DIR_UP; direction++) {
+            uint16_t next = autopilot_neighbour(cell, direction);
+
+            if (pilot->distance[next] != AUTOPILOT_UNREACHED || autopilot_is_free(game, next) == 0) {
+                continue;
+            }
+
+            pilot->distance[next] = pilot->distance[cell] + 1;
+            pilot->queue[write++] = next;
+        }
+    }
+
+    if (write > pilot->stats.visited_max) {
+        pilot->stats.visited_max = write;
+    }
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Chooses the next move.
+ *
+ * Only moves up to max_jump cells ahead in the cycle are allowed. It is
+ * the distance to the tail minus the slack, 1 (the next cell of the
+ * cycle) once the snake fills half the board, and never past the food.
+ * Among them, takes the closest to the food, then the longest jump.
+ *
+ * @param pilot Autopilot.
+ * @param game  Game.
+ *
+ * @return New direction.
+ */
+static snake_dir_t autopilot_decide(autopilot_t* pilot, const snake_game_t* game) {
+    uint16_t head = game->snake[game->head];
+    uint16_t tail = game->snake[SNAKE_RING(game->head + game->size - 1)];
+    uint16_t food = SNAKE_CELL(game->food.x, game->food.y);
+
+    uint16_t head_index = autopilot_cycle_index(head);
+    uint16_t to_tail = autopilot_cycle_distance(head_index, autopilot_cycle_index(tail));
+    uint16_t to_food = autopilot_cycle_distance(head_index, autopilot_cycle_index(food));
+
+    int16_t max_jump = (int16_t)to_tail - AUTOPILOT_SLACK;
+    if (2 * game->size > SNAKE_CELLS || max_jump < 1) {
+        max_jump = 1;
+    }
+    if (max_jump > to_food) {
+        max_jump = to_food;
+    }
+
+    autopilot_search(pilot, game);
+
+    snake_dir_t best = game->direction;
+    uint16_t best_distance = AUTOPILOT_UNREACHED;
+    uint16_t best_jump = 0;
+    snake_dir_t successor = game->direction;
+
+    for (uint8_t direction = SNAKE_DIR_RIGHT; direction <= SNAKE_DIR_UP; direction++) {
+        uint16_t next = autopilot_neighbour(head, direction);
+        uint16_t jump = autopilot_cycle_distance(head_index, autopilot_cycle_index(next));
+
+        if (jump == 1) {
+            successor = direction;
+        }
+
+        if (jump == 0 || jump > max_jump || autopilot_is_free(game, next) == 0) {
+            continue;
+        }
+
+        uint16_t distance = pilot->distance[next];
+        if (distance < best_distance || (distance == best_distance && jump > best_jump)) {
+            best = direction;
+            best_distance = distance;
+            best_jump = jump;
+        }
+    }
+
+    if (best_distance == AUTOPILOT_UNREACHED) {
+        // No allowed move gets closer to the food, follows the cycle
+        pilot->stats.no_path++;
+        return successor;
+    }
+
+    if (best_jump > 1) {
+        pilot->stats.shortcuts++;
+    }
+
+    return best;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup autopilot
+ * @brief Clears the autopilot statistics.
+ *
+ * @param pilot Autopilot.
+ */
+void autopilot_init(autopilot_t* pilot) {
+    memset(&pilot->stats, 0, sizeof(pilot->stats));
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Game input, see @ref snake_input_t.
+ *
+ * The game must have the autopilot as its input_context. Gives a key
+ * only to turn, so the game asks once per step. On the game over and
+ * win screens, gives a key at once to start a new game.
+ *
+ * @param game  Game.
+ * @param key   Output key, NULL when the game drops the queued keys.
+ *
+ * @return 1 if the snake turns, 0 otherwise.
+ */
+uint8_t autopilot_input(snake_game_t* game, keyboard_key_t* key) {
+    autopilot_t* pilot = game->input_context;
+
+    // Nothing queued
+    if (key == NULL) {
+        return 0;
+    }
+
+    if (game->state != SNAKE_STATE_PLAYING) {
+        *key = KEYBOARD_KEY_RIGHT;
+        return 1;
+    }
+
+    PROFILE_START(PROFILE_AUTOPILOT);
+    snake_dir_t direction = autopilot_decide(pilot, game);
+    PROFILE_END(PROFILE_AUTOPILOT);
+
+    pilot->stats.decisions++;
+    if (direction == game->direction) {
+        return 0;
+    }
+
+    // Directions and keys share the same order
+    *key = (keyboard_key_t)direction;
+    return 1;
+}
+
+/**
+ * @ingroup autopilot
+ * @brief Gets the autopilot statistics.
+ *
+ * @param pilot Autopilot.
+ * @param stats Output statistics.
+ */
+void autopilot_get_stats(const autopilot_t* pilot, autopilot_stats_t* stats) {
+    *stats = pilot->stats;
+}
@@ -0,0 +1,581 @@
+/**
+ * @file
+ * @ingroup bench
+ * @brief Benchmarks implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "bench.h"
+
+#if (BENCH_ENABLED == 1)
+
+#include "snake.h"
+#include "snake_lut.h"
+#include "autopilot.h"
+#include "keyboard.h"
+#include "nokia5110.h"
+
+#include "stm32f1xx_hal.h"
+
+#include <stdio.h>
+
+#ifdef SIMULATOR
+#include <time.h>
+#endif
+
+/* Private types -------------------------------------------------------------*/
+/**
+ * @ingroup bench
+ * @brief Duration statistics of a benchmark.
+ */
+typedef struct {
+    uint64_t total;     /**< Sum of all runs. */
+    uint32_t max;       /**< Longest run. */
+    uint32_t count;     /**< Number of runs. */
+} bench_timing_t;
+
+/**
+ * @ingroup bench
+ * @brief Key given to a timed step.
+ */
+typedef struct {
+    keyboard_key_t key; /**< Key. */
+    uint8_t pending;    /**< 1 until the key is read. */
+} bench_move_t;
+
+/**
+ * @ingroup bench
+ * @brief Timed game step.
+ */
+typedef void (*bench_step_fn_t)(snake_game_t* game, snake_input_t input);
+
+/* Private defines -----------------------------------------------------------*/
+#ifdef SIMULATOR
+#define BENCH_UNIT      "ns"
+#define BENCH_EOL       "\n"
+#else
+#define BENCH_UNIT      "cycles"
+#define BENCH_EOL       "\r\n"
+#endif
+
+#define BENCH_STEP_ROUNDS   256
+#define BENCH_DRAW_ROUNDS   100
+#define BENCH_FLUSH_ROUNDS  64
+#define BENCH_LINK_ROUNDS   16
+
+#define BENCH_SEED          1
+
+
+/* Private variables ---------------------------------------------------------*/
+static bench_format_t output_format = BENCH_FORMAT_CSV;
+static uint32_t result_nr = 0;
+
+// Snake sizes of the step benchmarks
+static const uint8_t step_sizes[] = { 3, 25, 50, 100, 150, 200 };
+
+// Game played by the autopilot up to each size, the start of the timed
+// steps, and the game stepped
+static snake_game_t play;
+static snake_game_t start;
+static snake_game_t work;
+static autopilot_t pilot;
+static bench_move_t move;
+
+// Result of the reference body scan, kept so the scan isn't optimized out
+static volatile uint8_t scan_hit;
+
+// Autopilot decision times over a game
+static bench_timing_t decide_timing;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t bench_now(void);
+static void bench_timing_add(bench_timing_t* timing, uint32_t duration);
+static void bench_report(const char* name, const char* param, const char* metric, uint32_t value, const char* unit);
+static void bench_report_timing(const char* name, const char* param, const bench_timing_t* timing);
+static uint8_t bench_move_input(snake_game_t* game, keyboard_key_t* key);
+static snake_pos_t bench_next_cell(snake_pos_t pos, snake_dir_t direction);
+static uint8_t bench_is_free(const snake_game_t* game, snake_pos_t pos);
+static void bench_step_scan(snake_game_t* game, snake_input_t input);
+static void bench_step(const char* name, const char* param, snake_dir_t direction, uint8_t headless,
+                       bench_step_fn_t step);
+static void bench_steps(void);
+static uint8_t bench_autopilot_input(snake_game_t* game, keyboard_key_t* key);
+static void bench_autopilot(void);
+static void bench_cell_per_pixel(uint8_t x, uint8_t y);
+static void bench_cell_block(uint8_t x, uint8_t y);
+static void bench_cell_lut(uint8_t x, uint8_t y);
+static void bench_draw(const char* param, void (*draw)(uint8_t x, uint8_t y));
+static void bench_flush(const char* param, uint8_t full);
+static void bench_link(void);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup bench
+ * @brief Reads the cycle counter, or the monotonic clock on the host.
+ */
+static uint32_t bench_now(void) {
+#ifdef SIMULATOR
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @ingroup bench
+ * @brief Adds a run to the duration statistics.
+ */
+static void bench_timing_add(bench_timing_t* timing, uint32_t duration) {
+    timing->total += duration;
+    timing->count++;
+    if (duration > timing->max) {
+        timing->max = duration;
+    }
+}
+
+/**
+ * @ingroup bench
+ * @brief Prints a result in the output format.
+ *
+ * @param name      Benchmark.
+ * @param param     Benchmark parameter.
+ * @param metric    What the value is (mean, max, bytes...).
+ * @param value     Value.
+ * @param unit      Value unit.
+ */
+static void bench_report(const char* name, const char* param, const char* metric, uint32_t value, const char* unit) {
+    if (output_format == BENCH_FORMAT_JSON) {
+        printf("%s  {\"benchmark\": \"%s\", \"param\": \"%s\", \"metric\": \"%s\", \"value\": %lu, \"unit\": \"%s\"}",
+               (result_nr == 0) ? "" : "," BENCH_EOL, name, param, metric, (unsigned long)value, unit);
+    } else {
+        printf("%s,%s,%s,%lu,%s" BENCH_EOL, name, param, metric, (unsigned long)value, unit);
+    }
+    result_nr++;
+}
+
+/**
+ * @ingroup bench
+ * @brief Prints the mean and max of a duration.
+ */
+static void bench_report_timing(const char* name, const char* param, const bench_timing_t* timing) {
+    if (timing->count == 0) {
+        return;
+    }
+
+    bench_report(name, param, "mean", timing->total / timing->count, BENCH_UNIT);
+    bench_report(name, param, "max", timing->max, BENCH_UNIT);
+}
+
+/**
+ * @ingroup bench
+ * @brief Game input of the timed steps, gives the prepared key once.
+ */
+static uint8_t bench_move_input(snake_game_t* game, keyboard_key_t* key) {
+    (void)game;
+
+    if (key == NULL || move.pending == 0) {
+        return 0;
+    }
+
+    *key = move.key;
+    move.pending = 0;
+    return 1;
+}
+
+/**
+ * @ingroup bench
+ * @brief Gets the neighbour cell, wrapping around the board edges.
+ */
+static snake_pos_t bench_next_cell(snake_pos_t pos, snake_dir_t direction) {
+    switch (direction) {
+        case SNAKE_DIR_RIGHT:
+            pos.x = (pos.x == SNAKE_MAX_X - 1) ? 0 : pos.x + 1;
+        break;
+        case SNAKE_DIR_DOWN:
+            pos.y = (pos.y == SNAKE_MAX_Y - 1) ? 0 : pos.y + 1;
+        break;
+        case SNAKE_DIR_LEFT:
+            pos.x = (pos.x == 0) ? SNAKE_MAX_X - 1 : pos.x - 1;
+        break;
+        case SNAKE_DIR_UP:
+            pos.y = (pos.y == 0) ? SNAKE_MAX_Y - 1 : pos.y - 1;
+        break;
+    }
+
+    return pos;
+}
+
+/**
+ * @ingroup bench
+ * @brief Checks if a cell isn't covered by the snake.
+ */
+static uint8_t bench_is_free(const snake_game_t* game, snake_pos_t pos) {
+    uint16_t cell = SNAKE_CELL(pos.x, pos.y);
+
+    return (game->free_slot[cell] < game->free_cell_nr);
+}
+
+/**
+ * @ingroup bench
+ * @brief Game step with the body scan collision check, the reference
+ * for the free cell index lookup.
+ *
+ * Compares the next head cell with every snake part, as the collision
+ * check did before the occupancy tracking, then steps the game. The
+ * lookup that replaced the scan is still run by the step, a few cycles.
+ */
+static void bench_step_scan(snake_game_t* game, snake_input_t input) {
+    snake_dir_t direction = (move.pending != 0) ? (snake_dir_t)move.key : game->direction;
+    snake_pos_t head = { .x = SNAKE_CELL_X(game->snake[game->head]), .y = SNAKE_CELL_Y(game->snake[game->head]) };
+    snake_pos_t next = bench_next_cell(head, direction);
+    snake_cell_t cell = SNAKE_CELL(next.x, next.y);
+    uint8_t hit = 0;
+
+    for (snake_index_t i = 0; i < game->size; i++) {
+        if (game->snake[SNAKE_RING(game->head + i)] == cell) {
+            hit = 1;
+            break;
+        }
+    }
+    scan_hit = hit;
+
+    snake_step(game, input);
+}
+
+/**
+ * @ingroup bench
+ * @brief Times a step from the start game, restored before each run.
+ *
+ * The screen update started by a drawn step is waited for out of the
+ * timed part.
+ *
+ * @param name      Benchmark.
+ * @param param     Benchmark parameter.
+ * @param direction Direction of the step.
+ * @param headless  0 to draw the step.
+ * @param step      Step to time, @ref snake_step or a reference.
+ */
+static void bench_step(const char* name, const char* param, snake_dir_t direction, uint8_t headless,
+                       bench_step_fn_t step) {
+    bench_timing_t timing = { 0 };
+
+    start.headless = headless;
+    for (uint16_t round = 0; round < BENCH_STEP_ROUNDS; round++) {
+        work = start;
+        move.key = (keyboard_key_t)direction;
+        move.pending = (direction != start.direction);
+
+        uint32_t begin = bench_now();
+        step(&work, bench_move_input);
+        bench_timing_add(&timing, bench_now() - begin);
+
+        while (nokia5110_is_busy() != 0) {
+        }
+    }
+
+    bench_report_timing(name, param, &timing);
+}
+
+/**
+ * @ingroup bench
+ * @brief Times the game steps against the snake size.
+ *
+ * The autopilot plays a game up to each size. From there, times a
+ * plain step (headless and drawn), the same step with the body scan
+ * collision check of the original game, a step onto the food, which
+ * places the next one on the remaining free cells, and a step into the
+ * body, the worst case of the collision check.
+ */
+static void bench_steps(void) {
+    char param[16];
+
+    autopilot_init(&pilot);
+    play = (snake_game_t){ 0 };
+    play.headless = 1;
+    play.input_context = &pilot;
+    snake_seed(&play, BENCH_SEED);
+    snake_init(&play);
+
+    for (uint8_t i = 0; i < sizeof(step_sizes); i++) {
+        while (play.size < step_sizes[i] && play.state == SNAKE_STATE_PLAYING) {
+            snake_step(&play, autopilot_input);
+        }
+        if (play.state != SNAKE_STATE_PLAYING) {
+            break;
+        }
+
+        snprintf(param, sizeof(param), "size=%u", play.size);
+
+        // Safe direction of the autopilot, without changing the game
+        keyboard_key_t key;
+        snake_dir_t safe = play.direction;
+
+        start = play;
+        if (autopilot_input(&start, &key) != 0) {
+            safe = (snake_dir_t)key;
+        }
+
+        snake_pos_t head = { .x = SNAKE_CELL_X(play.snake[play.head]), .y = SNAKE_CELL_Y(play.snake[play.head]) };
+        snake_pos_t next = bench_next_cell(head, safe);
+
+        start = play;
+        if (next.x == start.food.x && next.y == start.food.y) {
+            // Moves the food away from the plain step
+            start.food = bench_next_cell(next, safe);
+        }
+        bench_step("snake_step", param, safe, 1, snake_step);
+        bench_step("snake_step_scan", param, safe, 1, bench_step_scan);
+        bench_step("snake_step_drawn", param, safe, 0, snake_step);
+
+        start = play;
+        start.food = next;
+        bench_step("snake_step_eat", param, safe, 1, snake_step);
+
+        // Any direction into the body but the neck
+        for (uint8_t direction = SNAKE_DIR_RIGHT; direction <= SNAKE_DIR_UP; direction++) {
+            if (direction == ((play.direction + 2) & 3)) {
+                continue;
+            }
+            if (bench_is_free(&play, bench_next_cell(head, direction)) == 0) {
+                start = play;
+                bench_step("snake_step_collision", param, direction, 1, snake_step);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @ingroup bench
+ * @brief Game input timing each autopilot decision.
+ */
+static uint8_t bench_autopilot_input(snake_game_t* game, keyboard_key_t* key) {
+    if (key == NULL) {
+        return autopilot_input(game, key);
+    }
+
+    uint32_t begin = bench_now();
+    uint8_t moved = autopilot_input(game, key);
+    bench_timing_add(&decide_timing, bench_now() - begin);
+
+    return moved;
+}
+
+/**
+ * @ingroup bench
+ * @brief Times the autopilot decisions over a whole game.
+ *
+ * The autopilot plays a headless game up to the win, the search growing
+ * with the free cells early on and the cycle taking over later, and the
+ * longest decision is the worst case of that game.
+ */
+static void bench_autopilot(void) {
+    autopilot_stats_t stats;
+
+    decide_timing = (bench_timing_t){ 0 };
+    autopilot_init(&pilot);
+    play = (snake_game_t){ 0 };
+    play.headless = 1;
+    play.input_context = &pilot;
+    snake_seed(&play, BENCH_SEED);
+    snake_init(&play);
+
+    while (play.state == SNAKE_STATE_PLAYING) {
+        snake_step(&play, bench_autopilot_input);
+    }
+
+    autopilot_get_stats(&pilot, &stats);
+    bench_report_timing("autopilot_decide", "game", &decide_timing);
+    bench_report("autopilot_decide", "game", "decisions", decide_timing.count, "decisions");
+    bench_report("autopilot_decide", "game", "visited_max", stats.visited_max, "cells");
+    bench_report("autopilot_decide", "game", "size", play.size, "cells");
+}
+
+/**
+ * @ingroup bench
+ * @brief Draws and erases a board cell one pixel at a time.
+ */
+static void bench_cell_per_pixel(uint8_t x, uint8_t y) {
+    x = SNAKE_X_0 + SNAKE_PART_SIZE * x;
+    y = SNAKE_Y_0 + SNAKE_PART_SIZE * y;
+
+    for (uint8_t i = 0; i < SNAKE_PART_SIZE; i++) {
+        for (uint8_t j = 0; j < SNAKE_PART_SIZE; j++) {
+            nokia5110_set_pixel(x + i, y + j);
+        }
+    }
+    for (uint8_t i = 0; i < SNAKE_PART_SIZE; i++) {
+        for (uint8_t j = 0; j < SNAKE_PART_SIZE; j++) {
+            nokia5110_clr_pixel(x + i, y + j);
+        }
+    }
+}
+
+/**
+ * @ingroup bench
+ * @brief Draws and erases a board cell with the block primitives.
+ */
+static void bench_cell_block(uint8_t x, uint8_t y) {
+    x = SNAKE_X_0 + SNAKE_PART_SIZE * x;
+    y = SNAKE_Y_0 + SNAKE_PART_SIZE * y;
+
+    nokia5110_set_block(x, y, SNAKE_PART_SIZE, SNAKE_PART_SIZE);
+    nokia5110_clr_block(x, y, SNAKE_PART_SIZE, SNAKE_PART_SIZE);
+}
+
+/**
+ * @ingroup bench
+ * @brief Draws and erases a board cell from the cell lookup tables, as
+ * the game does.
+ */
+static void bench_cell_lut(uint8_t x, uint8_t y) {
+    uint16_t offset = snake_lut_offset[SNAKE_CELL(x, y)];
+
+    nokia5110_set_columns(offset, SNAKE_PART_SIZE, snake_lut_mask[y][0], snake_lut_mask[y][1]);
+    nokia5110_clr_columns(offset, SNAKE_PART_SIZE, snake_lut_mask[y][0], snake_lut_mask[y][1]);
+}
+
+/**
+ * @ingroup bench
+ * @brief Times drawing and erasing every board cell.
+ *
+ * @param param Primitive name.
+ * @param draw  Cell draw and erase function, given the cell coordinates.
+ */
+static void bench_draw(const char* param, void (*draw)(uint8_t x, uint8_t y)) {
+    bench_timing_t timing = { 0 };
+
+    for (uint16_t round = 0; round < BENCH_DRAW_ROUNDS; round++) {
+        uint32_t begin = bench_now();
+
+        for (uint8_t y = 0; y < SNAKE_MAX_Y; y++) {
+            for (uint8_t x = 0; x < SNAKE_MAX_X; x++) {
+                draw(x, y);
+            }
+        }
+        bench_timing_add(&timing, (bench_now() - begin) / SNAKE_CELLS);
+    }
+
+    bench_report_timing("cell_draw", param, &timing);
+}
+
+/**
+ * @ingroup bench
+ * @brief Times a blocking screen update and counts its SPI bytes.
+ *
+ * @param param Benchmark parameter.
+ * @param full  1 to send the whole frame, 0 to send a single changed cell.
+ */
+static void bench_flush(const char* param, uint8_t full) {
+    bench_timing_t timing = { 0 };
+    nokia5110_stats_t stats = { 0 };
+
+    for (uint16_t round = 0; round < BENCH_FLUSH_ROUNDS; round++) {
+        if (full != 0) {
+            nokia5110_clear_buffer();
+        } else if (round % 2 == 0) {
+            nokia5110_set_block(SNAKE_X_0, SNAKE_Y_0, SNAKE_PART_SIZE, SNAKE_PART_SIZE);
+        } else {
+            nokia5110_clr_block(SNAKE_X_0, SNAKE_Y_0, SNAKE_PART_SIZE, SNAKE_PART_SIZE);
+        }
+
+        uint32_t begin = bench_now();
+        nokia5110_update_screen();
+        bench_timing_add(&timing, bench_now() - begin);
+    }
+
+    nokia5110_get_stats(&stats);
+    bench_report_timing("flush", param, &timing);
+    bench_report("flush", param, "bytes", stats.data_bytes + stats.cmd_bytes, "bytes");
+    bench_report("flush", param, "cmd_bytes", stats.cmd_bytes, "bytes");
+}
+
+/**
+ * @ingroup bench
+ * @brief Runs the display link test, then times a full frame at each SPI
+ * clock divider tested.
+ *
+ * The link test result is only given when the patterns were read back
+ * (see @ref nokia5110_link_test), the bench otherwise can't tell a
+ * divider that corrupts the data.
+ *
+ * The wire time is the frame bits at the SPI clock, the time on target
+ * when the CPU keeps up. The simulator SPI takes no time, so only the
+ * wire time means something there.
+ */
+static void bench_link(void) {
+    nokia5110_link_result_t results[NOKIA5110_LINK_DIVIDERS_NR];
+    uint8_t result_nr = nokia5110_link_test(results);
+    uint16_t tuned = nokia5110_get_link_divider();
+
+    for (uint8_t i = 0; i < result_nr; i++) {
+        bench_timing_t timing = { 0 };
+        nokia5110_stats_t stats = { 0 };
+        char param[12];
+
+        nokia5110_set_link_divider(results[i].divider);
+        for (uint16_t round = 0; round < BENCH_LINK_ROUNDS; round++) {
+            nokia5110_clear_buffer();
+
+            uint32_t begin = bench_now();
+            nokia5110_update_screen();
+            bench_timing_add(&timing, bench_now() - begin);
+        }
+        nokia5110_get_stats(&stats);
+
+        uint32_t bits = (stats.data_bytes + stats.cmd_bytes) * 8U;
+
+        snprintf(param, sizeof(param), "div%u", results[i].divider);
+        bench_report("link", param, "rate", results[i].rate_hz / 1000, "kbit/s");
+        bench_report("link", param, "verified", results[i].verified, "bool");
+        if (results[i].verified != 0) {
+            bench_report("link", param, "passed", results[i].passed, "bool");
+        }
+        bench_report("link", param, "wire", (uint32_t)((uint64_t)bits * 1000000 / results[i].rate_hz), "us");
+        bench_report_timing("link", param, &timing);
+    }
+
+    nokia5110_set_link_divider(tuned);
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup bench
+ * @brief Runs all the benchmarks and prints the results.
+ *
+ * Takes a few seconds on target. The display shows garbage meanwhile.
+ *
+ * @param format    Output format.
+ */
+void bench_run(bench_format_t format) {
+#ifndef SIMULATOR
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    output_format = format;
+    result_nr = 0;
+
+    if (output_format == BENCH_FORMAT_JSON) {
+        printf("[" BENCH_EOL);
+    } else {
+        printf("benchmark,param,metric,value,unit" BENCH_EOL);
+    }
+
+    bench_steps();
+    bench_autopilot();
+    bench_draw("per_pixel", bench_cell_per_pixel);
+    bench_draw("block", bench_cell_block);
+    bench_draw("lut", bench_cell_lut);
+    bench_flush("full", 1);
+    bench_flush("partial", 0);
+    bench_link();
+
+    if (output_format == BENCH_FORMAT_JSON) {
+        printf(BENCH_EOL "]" BENCH_EOL);
+    }
+}
+
+#endif /* BENCH_ENABLED */
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @ingroup debounce
+ * @brief Debounce implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "debounce.h"
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup debounce
+ * @brief Sets the debounced levels and resets the counters.
+ *
+ * @param debounce  Debounce state.
+ * @param initial   Initial levels.
+ */
+void debounce_init(debounce_t* debounce, uint32_t initial) {
+    debounce->state = initial;
+    debounce->count0 = 0xFFFFFFFF;
+    debounce->count1 = 0xFFFFFFFF;
+}
+
+/**
+ * @ingroup debounce
+ * @brief Adds a sample of all the inputs.
+ *
+ * The counters of the inputs that differ from their debounced level
+ * count down from 3 and roll over on the DEBOUNCE_SAMPLES-th sample,
+ * which toggles the level. The others are set back to 3.
+ *
+ * @param debounce  Debounce state.
+ * @param sample    Input levels.
+ *
+ * @return Inputs whose debounced level changed.
+ */
+uint32_t debounce_update(debounce_t* debounce, uint32_t sample) {
+    uint32_t changed = debounce->state ^ sample;
+
+    debounce->count0 = ~(debounce->count0 & changed);
+    debounce->count1 = debounce->count0 ^ (debounce->count1 & changed);
+
+    changed &= debounce->count0 & debounce->count1;
+    debounce->state ^= changed;
+
+    return changed;
+}
+
+/**
+ * @ingroup debounce
+ * @brief Checks if no input is in the middle of a change.
+ *
+ * @return 1 if all the counters are reset, 0 otherwise.
+ */
+uint8_t debounce_is_stable(const debounce_t* debounce) {
+    return ((debounce->count0 & debounce->count1) == 0xFFFFFFFF);
+}
@@ -0,0 +1,289 @@
+/**
+ * @file
+ * @ingroup keyboard
+ * @brief Keyboard implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "keyboard.h"
+
+#include "debounce.h"
+
+#include "stm32f1xx_hal.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define KEYBOARD_PORT           GPIOB
+#define KEYBOARD_CLOCK_EN()     __HAL_RCC_GPIOB_CLK_ENABLE()
+#define KEYBOARD_RIGHT_PIN      GPIO_PIN_12
+#define KEYBOARD_DOWN_PIN       GPIO_PIN_13
+#define KEYBOARD_LEFT_PIN       GPIO_PIN_14
+#define KEYBOARD_UP_PIN         GPIO_PIN_15
+#define KEYBOARD_PINS           (KEYBOARD_RIGHT_PIN | KEYBOARD_DOWN_PIN | KEYBOARD_LEFT_PIN | KEYBOARD_UP_PIN)
+#define KEYBOARD_IRQ            EXTI15_10_IRQn
+#define KEYBOARD_IRQ_PRIORITY   3
+
+/* Private variables ---------------------------------------------------------*/
+#if (KEYBOARD_USE_EXTI == 1)
+static const uint16_t key_pins[KEYBOARD_KEYS_NR] = {
+    [KEYBOARD_KEY_RIGHT] = KEYBOARD_RIGHT_PIN,
+    [KEYBOARD_KEY_DOWN] = KEYBOARD_DOWN_PIN,
+    [KEYBOARD_KEY_LEFT] = KEYBOARD_LEFT_PIN,
+    [KEYBOARD_KEY_UP] = KEYBOARD_UP_PIN,
+};
+
+// Last edge of each key, written by the IRQ only
+static uint32_t last_edge_ms[KEYBOARD_KEYS_NR] = { 0 };
+#else
+static debounce_t debounce = { 0 };
+static uint32_t last_sample_ms = 0;
+#endif
+
+// Free running indexes: head is written by the producer only, tail by the main loop only
+static keyboard_event_t queue[KEYBOARD_QUEUE_SIZE] = { 0 };
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static volatile uint32_t dropped = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t keyboard_sample(void);
+static void keyboard_push(keyboard_key_t key, uint32_t time_ms);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup keyboard
+ * @brief Reads all the keys with a single port access.
+ *
+ * @return Keys down, one bit per key (see KEYBOARD_KEY_MASK).
+ */
+static uint8_t keyboard_sample(void) {
+    // PB12 to PB15 are the keys in keyboard_key_t order, active low
+    return (uint8_t)((~KEYBOARD_PORT->IDR & KEYBOARD_PINS) >> 12);
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Queues a key press.
+ *
+ * Only called by the producer side (the EXTI IRQ or the poll).
+ *
+ * @param key       Key pressed.
+ * @param time_ms   HAL tick of the press.
+ */
+static void keyboard_push(keyboard_key_t key, uint32_t time_ms) {
+    uint8_t head = queue_head;
+
+    if ((uint8_t)(head - queue_tail) == KEYBOARD_QUEUE_SIZE) {
+        dropped++;
+        return;
+    }
+
+    queue[head % KEYBOARD_QUEUE_SIZE].time_ms = time_ms;
+    queue[head % KEYBOARD_QUEUE_SIZE].key = key;
+
+    // The slot is written before it's handed to the consumer
+    __DMB();
+    queue_head = head + 1;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup keyboard
+ * @brief Sets up the keys as EXTI inputs and empties the queue.
+ *
+ * In polling mode only the falling edges are enabled, to wake the MCU
+ * from Stop mode.
+ */
+void keyboard_init(void) {
+    GPIO_InitTypeDef gpio_init = { 0 };
+
+    KEYBOARD_CLOCK_EN();
+
+    gpio_init.Pin = KEYBOARD_PINS;
+#if (KEYBOARD_USE_EXTI == 1)
+    gpio_init.Mode = GPIO_MODE_IT_RISING_FALLING;
+#else
+    gpio_init.Mode = GPIO_MODE_IT_FALLING;
+#endif
+    gpio_init.Pull = GPIO_PULLUP;
+    gpio_init.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(KEYBOARD_PORT, &gpio_init);
+
+#if (KEYBOARD_USE_EXTI == 0)
+    debounce_init(&debounce, keyboard_sample());
+    last_sample_ms = HAL_GetTick();
+#endif
+
+    keyboard_clear();
+
+    HAL_NVIC_SetPriority(KEYBOARD_IRQ, KEYBOARD_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(KEYBOARD_IRQ);
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Samples and debounces the keys (polling mode).
+ *
+ * Must be called from the main loop at least every KEYBOARD_SAMPLE_MS.
+ * Keys that get down in the same sample (a chord) are queued in
+ * keyboard_key_t order. Does nothing in EXTI mode.
+ */
+void keyboard_poll(void) {
+#if (KEYBOARD_USE_EXTI == 0)
+    uint32_t now = HAL_GetTick();
+
+    if (now - last_sample_ms < KEYBOARD_SAMPLE_MS) {
+        return;
+    }
+    last_sample_ms = now;
+
+    uint32_t pressed = debounce_update(&debounce, keyboard_sample()) & debounce.state;
+
+    for (uint8_t key = 0; key < KEYBOARD_KEYS_NR; key++) {
+        if (pressed & KEYBOARD_KEY_MASK(key)) {
+            keyboard_push(key, now);
+        }
+    }
+#endif
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Takes the oldest key press from the queue.
+ *
+ * @param event     Output event.
+ *
+ * @return 1 if an event was read, 0 if the queue is empty.
+ */
+uint8_t keyboard_read(keyboard_event_t* event) {
+    uint8_t tail = queue_tail;
+
+    if (tail == queue_head) {
+        return 0;
+    }
+
+    *event = queue[tail % KEYBOARD_QUEUE_SIZE];
+
+    // The slot is read before it's handed back to the IRQ
+    __DMB();
+    queue_tail = tail + 1;
+
+    return 1;
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Gets the number of queued key presses.
+ */
+uint8_t keyboard_pending(void) {
+    return (uint8_t)(queue_head - queue_tail);
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Gets the keys held down, to detect chords.
+ *
+ * The levels are debounced in polling mode and raw in EXTI mode.
+ *
+ * @return Keys down, one bit per key (see KEYBOARD_KEY_MASK).
+ */
+uint8_t keyboard_held(void) {
+#if (KEYBOARD_USE_EXTI == 1)
+    return keyboard_sample();
+#else
+    return (uint8_t)debounce.state;
+#endif
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Checks if there is nothing left for the keyboard to report.
+ *
+ * In polling mode a key on its way down, or held, still needs samples
+ * (its falling edge is gone), so the MCU mustn't enter Stop mode.
+ *
+ * @return 1 if idle, 0 otherwise.
+ */
+uint8_t keyboard_is_idle(void) {
+    if (keyboard_pending() != 0) {
+        return 0;
+    }
+
+#if (KEYBOARD_USE_EXTI == 0)
+    if (keyboard_sample() != 0 || debounce.state != 0 || debounce_is_stable(&debounce) == 0) {
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Drops the queued key presses.
+ */
+void keyboard_clear(void) {
+    queue_tail = queue_head;
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Gets the number of key presses dropped because the queue was full.
+ */
+uint32_t keyboard_dropped(void) {
+    return dropped;
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Handles the keys EXTI lines interrupt.
+ *
+ * Must be called from the EXTI15_10 IRQ handler. In polling mode it only
+ * clears the lines.
+ */
+void keyboard_irq_handler(void) {
+    HAL_GPIO_EXTI_IRQHandler(KEYBOARD_RIGHT_PIN);
+    HAL_GPIO_EXTI_IRQHandler(KEYBOARD_DOWN_PIN);
+    HAL_GPIO_EXTI_IRQHandler(KEYBOARD_LEFT_PIN);
+    HAL_GPIO_EXTI_IRQHandler(KEYBOARD_UP_PIN);
+
+    keyboard_edge_callback();
+}
+
+/**
+ * @ingroup keyboard
+ * @brief Key edge callback.
+ *
+ * Called from the EXTI interrupt after the edge was handled (the press
+ * queued in EXTI mode). Override it to wake up the code that polls the
+ * keyboard or reads the queue.
+ */
+__weak void keyboard_edge_callback(void) {
+}
+
+#if (KEYBOARD_USE_EXTI == 1)
+/**
+ * @ingroup keyboard
+ * @brief EXTI line callback, debounces the edge and queues presses.
+ *
+ * The pin is read right after the edge to tell a press (low) from a
+ * release (high).
+ *
+ * @param pin   Pin of the EXTI line.
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t pin) {
+    for (uint8_t key = 0; key < KEYBOARD_KEYS_NR; key++) {
+        if (key_pins[key] != pin) {
+            continue;
+        }
+
+        uint32_t now = HAL_GetTick();
+        uint32_t stable_ms = now - last_edge_ms[key];
+
+        last_edge_ms[key] = now;
+
+        if (stable_ms >= KEYBOARD_DEBOUNCE_MS && HAL_GPIO_ReadPin(KEYBOARD_PORT, pin) == GPIO_PIN_RESET) {
+            keyboard_push(key, now);
+        }
+        return;
+    }
+}
+#endif
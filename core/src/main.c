@@ -5,16 +5,33 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 #include "snake.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "power.h"
+#include "keyboard.h"
+#include "replay.h"
+#include "autopilot.h"
+#include "bench.h"
+#include "rtos.h"
+#include "nokia5110.h"
 
 #include "stm32f1xx_hal.h"
 
 /* Private types -------------------------------------------------------------*/
 
 /* Private defines -----------------------------------------------------------*/
+#define PROFILE_DUMP_PERIOD_MS  10000
 
 /* Private variables ---------------------------------------------------------*/
+// Displayed game, at the display origin
+static snake_game_t game = { 0 };
+
+#if (AUTOPILOT_ENABLED == 1)
+static autopilot_t pilot;
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 static void clock_config(void);
@@ -48,16 +65,118 @@ static void clock_config(void)
 }
 
 /* Public functions ----------------------------------------------------------*/
+/**
+ * @brief Sends the printf output (see syscalls.c) to the SWO pin.
+ *
+ * Uses the ITM stimulus port 0. Characters are dropped when no debugger
+ * enabled the ITM.
+ */
+int __io_putchar(int ch) {
+    return ITM_SendChar(ch);
+}
+
 /**
  * @brief Main function.
  */
 int main(void) {
     HAL_Init();
     clock_config();
+    profile_init();
+    power_init(clock_config);
+    keyboard_init();
+
+    // Records each game from boot, or plays the one saved in flash
+    replay_status_t replay;
+#if (REPLAY_FROM_FLASH == 1)
+    if (replay_flash_load() == 0) {
+        replay_record(SNAKE_DEFAULT_SEED);
+    }
+#else
+    replay_record(SNAKE_DEFAULT_SEED);
+#endif
+    replay_get_status(&replay);
+#if (REPLAY_SAVE_TO_FLASH == 1)
+    uint16_t replay_saved_game = 0;
+#endif
+
+    nokia5110_setup();
+    bench_run(BENCH_FORMAT_CSV);
+#if (AUTOPILOT_ENABLED == 1)
+    autopilot_init(&pilot);
+    game.input_context = &pilot;
+#endif
+    // The board may not cover the whole display
+    nokia5110_clear_buffer();
+    snake_seed(&game, replay.seed);
+    snake_init(&game);
 
-    snake_init();
+    // Runs the game in the RTOS tasks from here, never returns
+#if (AUTOPILOT_ENABLED == 1)
+    rtos_start(&game, autopilot_input);
+#else
+    rtos_start(&game, replay_input);
+#endif
+
+    scheduler_init(SCHEDULER_STEP_HZ);
+
+#if (PROFILE_ENABLED == 1)
+    uint32_t dump_timeshot = HAL_GetTick();
+#endif
 
     while(true) {
-        snake_update();
+        // Sleeps until the next base tick
+        scheduler_wait();
+        keyboard_poll();
+        if (scheduler_step_due() != 0) {
+#if (AUTOPILOT_ENABLED == 1)
+            snake_step(&game, autopilot_input);
+#else
+            snake_step(&game, replay_input);
+#endif
+        }
+
+#if (REPLAY_SAVE_TO_FLASH == 1)
+        // Keeps the last game in flash on its game over screen, for bug reports
+        replay_get_status(&replay);
+        if (snake_is_idle(&game) != 0 && replay.mode == REPLAY_RECORDING && replay.games != replay_saved_game) {
+            replay_flash_save();
+            replay_saved_game = replay.games;
+        }
+#endif
+
+        // Nothing to draw until a key is pressed, the autopilot never waits
+        __disable_irq();
+        if (AUTOPILOT_ENABLED == 0 && snake_is_idle(&game) != 0 && keyboard_is_idle() != 0 &&
+            replay_is_playing() == 0 && nokia5110_is_busy() == 0) {
+            power_stop();
+        }
+        __enable_irq();
+
+#if (PROFILE_ENABLED == 1)
+        if (HAL_GetTick() - dump_timeshot >= PROFILE_DUMP_PERIOD_MS) {
+            scheduler_stats_t stats;
+
+            dump_timeshot = HAL_GetTick();
+            profile_dump();
+
+            scheduler_get_stats(&stats);
+            printf("steps %lu, overruns %lu, latency %lu-%lu us\r\n",
+                   stats.steps, stats.overruns, stats.latency_min_us, stats.latency_max_us);
+
+            power_stats_t power;
+            power_get_stats(&power);
+            printf("run %lu ms, sleep %lu ms, stop %lu ms (%lu stops, clock restore %lu us, max %lu us)\r\n",
+                   power.time_ms[POWER_RUN], power.time_ms[POWER_SLEEP], power.time_ms[POWER_STOP],
+                   power.stops, power.clock_restore_us, power.clock_restore_max_us);
+            printf("keys dropped %lu\r\n", keyboard_dropped());
+            printf("replay %u keys, %u bytes, %u not recorded\r\n", replay.events, replay.size, replay.overflow);
+#if (AUTOPILOT_ENABLED == 1)
+            autopilot_stats_t autopilot;
+            autopilot_get_stats(&pilot, &autopilot);
+            printf("autopilot %lu decisions, %lu shortcuts, %lu with no path, %u cells searched at most\r\n",
+                   autopilot.decisions, autopilot.shortcuts, autopilot.no_path, autopilot.visited_max);
+#endif
+        }
+#endif
     }
 }
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * @ingroup power
+ * @brief Power manager implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "power.h"
+
+#include "stm32f1xx_hal.h"
+
+#include <stddef.h>
+
+/* Private defines -----------------------------------------------------------*/
+// RTC clocked by the LSE divided by 32: 1024 counts per second
+#define POWER_LSE_HZ    32768
+#define POWER_RTC_HZ    1024
+#define POWER_RTC_DIV   (POWER_LSE_HZ / POWER_RTC_HZ)
+
+/* Private variables ---------------------------------------------------------*/
+static RTC_HandleTypeDef rtc_handle = { 0 };
+static void (*clock_restore_callback)(void) = NULL;
+
+static uint32_t rtc_start = 0;
+static uint64_t stop_lse_ticks = 0;
+static uint32_t last_cycles = 0;
+static uint64_t run_cycles = 0;
+
+static power_stats_t stats = { 0 };
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t power_rtc_now(void);
+static uint32_t power_lse_now(void);
+static void power_count_run(void);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup power
+ * @brief Reads the RTC counter.
+ *
+ * The counter is split in two 16 bits registers, so the low half is
+ * read again if the high half changed in between.
+ *
+ * @return RTC counts (POWER_RTC_HZ per second).
+ */
+static uint32_t power_rtc_now(void) {
+    uint16_t high = RTC->CNTH;
+    uint16_t low = RTC->CNTL;
+
+    if (RTC->CNTH != high) {
+        high = RTC->CNTH;
+        low = RTC->CNTL;
+    }
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+ * @ingroup power
+ * @brief Reads the RTC counter and prescaler as a LSE time stamp.
+ *
+ * The prescaler counts the LSE periods down to the next counter
+ * increment, so the counter is read again if it moved in between.
+ *
+ * @return LSE periods (POWER_LSE_HZ per second).
+ */
+static uint32_t power_lse_now(void) {
+    uint32_t rtc;
+    uint32_t div;
+
+    do {
+        rtc = power_rtc_now();
+        div = RTC->DIVL;
+    } while (power_rtc_now() != rtc);
+
+    return rtc * POWER_RTC_DIV + (POWER_RTC_DIV - 1 - div);
+}
+
+/**
+ * @ingroup power
+ * @brief Adds the cycles run since the last call to the run time.
+ *
+ * Must be called more often than the cycle counter wraps (59 s at 72 MHz).
+ */
+static void power_count_run(void) {
+    uint32_t cycles = DWT->CYCCNT;
+
+    run_cycles += cycles - last_cycles;
+    last_cycles = cycles;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup power
+ * @brief Sets up the power manager.
+ *
+ * Starts the LSE and the RTC and enables the cycle counter.
+ *
+ * @param clock_restore     Clock configuration to run after a Stop mode
+ *                          wake up (the PLL is off then).
+ */
+void power_init(void (*clock_restore)(void)) {
+    RCC_OscInitTypeDef osc_init = { 0 };
+    RCC_PeriphCLKInitTypeDef clk_init = { 0 };
+
+    clock_restore_callback = clock_restore;
+
+    // The RTC is in the backup domain
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    osc_init.OscillatorType = RCC_OSCILLATORTYPE_LSE;
+    osc_init.LSEState = RCC_LSE_ON;
+    osc_init.PLL.PLLState = RCC_PLL_NONE;
+    HAL_RCC_OscConfig(&osc_init);
+
+    clk_init.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+    clk_init.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
+    HAL_RCCEx_PeriphCLKConfig(&clk_init);
+    __HAL_RCC_RTC_ENABLE();
+
+    rtc_handle.Instance = RTC;
+    rtc_handle.Init.AsynchPrediv = POWER_RTC_DIV - 1;
+    rtc_handle.Init.OutPut = RTC_OUTPUTSOURCE_NONE;
+    HAL_RTC_Init(&rtc_handle);
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    last_cycles = DWT->CYCCNT;
+    run_cycles = 0;
+    stop_lse_ticks = 0;
+    rtc_start = power_rtc_now();
+}
+
+/**
+ * @ingroup power
+ * @brief Enters Sleep mode until the next interrupt.
+ *
+ * May be called with interrupts disabled: a pending interrupt still
+ * wakes the core, and its handler runs once they are enabled again.
+ */
+void power_sleep(void) {
+    power_count_run();
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+}
+
+/**
+ * @ingroup power
+ * @brief Enters Stop mode until an EXTI interrupt (a key, see @ref keyboard).
+ *
+ * Must be called with interrupts disabled, right after checking there
+ * is nothing to do, so an event in between still wakes the MCU up, and
+ * returns with them disabled. On wake up, the tick and the interrupts
+ * are enabled before the clock restore, since the HAL clock set up
+ * times its waits with HAL_GetTick: the pending interrupt handlers run
+ * then, from HSI.
+ *
+ * The Stop time and the clock restore time are taken from the RTC, at
+ * the LSE resolution (31 us). The Stop time ends once the RTC registers
+ * are synchronized again after the wake up, so it holds the Stop mode
+ * exit (regulator and HSI start up, a few us). The clock restore time,
+ * pending interrupt handlers included, is counted as run time from the
+ * RTC too, since the cycle counter runs from HSI meanwhile.
+ *
+ * @note The display transfer must be finished (see @ref nokia5110_is_busy),
+ * since the SPI and DMA clocks stop.
+ */
+void power_stop(void) {
+    power_count_run();
+    HAL_SuspendTick();
+    uint32_t stop_start = power_lse_now();
+
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    // Running from HSI, the HAL timeouts need the tick interrupt
+    HAL_ResumeTick();
+    __enable_irq();
+
+    // The RTC registers read stale until the APB1 interface synchronizes
+    HAL_RTC_WaitForSynchro(&rtc_handle);
+    uint32_t wake = power_lse_now();
+    stop_lse_ticks += wake - stop_start;
+    if (clock_restore_callback != NULL) {
+        clock_restore_callback();
+    }
+
+    __disable_irq();
+    uint32_t restore = power_lse_now() - wake;
+    uint32_t restore_us = (uint32_t)(((uint64_t)restore * 1000000) / POWER_LSE_HZ);
+
+    // Run time at the restored clock, the cycles counted from HSI are dropped
+    run_cycles += ((uint64_t)restore * SystemCoreClock) / POWER_LSE_HZ;
+    last_cycles = DWT->CYCCNT;
+
+    stats.stops++;
+    stats.clock_restore_us = restore_us;
+    if (restore_us > stats.clock_restore_max_us) {
+        stats.clock_restore_max_us = restore_us;
+    }
+}
+
+/**
+ * @ingroup power
+ * @brief Gets the power manager statistics.
+ *
+ * @param output    Output statistics.
+ */
+void power_get_stats(power_stats_t* output) {
+    power_count_run();
+
+    uint32_t total_ms = (uint32_t)(((uint64_t)(power_rtc_now() - rtc_start) * 1000) / POWER_RTC_HZ);
+    uint32_t stop_ms = (uint32_t)((stop_lse_ticks * 1000) / POWER_LSE_HZ);
+    uint32_t run_ms = (uint32_t)(run_cycles / (SystemCoreClock / 1000));
+
+    *output = stats;
+    output->time_ms[POWER_RUN] = run_ms;
+    output->time_ms[POWER_STOP] = stop_ms;
+    output->time_ms[POWER_SLEEP] = (total_ms > run_ms + stop_ms) ? total_ms - run_ms - stop_ms : 0;
+}
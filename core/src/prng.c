@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @ingroup prng
+ * @brief Pseudo random numbers implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "prng.h"
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup prng
+ * @brief Seeds the generator.
+ *
+ * @param prng  Generator.
+ * @param seed  Any value, 0 is replaced by PRNG_ZERO_SEED.
+ */
+void prng_seed(prng_t* prng, uint32_t seed) {
+    prng->state = (seed != 0) ? seed : PRNG_ZERO_SEED;
+}
+
+/**
+ * @ingroup prng
+ * @brief Gets the next number.
+ *
+ * @param prng  Generator.
+ *
+ * @return Number from 1 to 2^32 - 1.
+ */
+uint32_t prng_next(prng_t* prng) {
+    uint32_t x = prng->state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    prng->state = x;
+
+    return x;
+}
+
+/**
+ * @ingroup prng
+ * @brief Gets a number in a range with a single draw.
+ *
+ * Scales the draw with a multiply instead of a division. The bias is
+ * below bound / 2^32, negligible for board sized ranges.
+ *
+ * @param prng  Generator.
+ * @param bound Range size, not 0.
+ *
+ * @return Number from 0 to bound - 1.
+ */
+uint32_t prng_below(prng_t* prng, uint32_t bound) {
+    return (uint32_t)(((uint64_t)prng_next(prng) * bound) >> 32);
+}
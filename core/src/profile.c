@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @ingroup profile
+ * @brief Hot path profiling implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "profile.h"
+
+#if (PROFILE_ENABLED == 1)
+
+#include <stdio.h>
+
+#ifdef SIMULATOR
+#include <time.h>
+#endif
+
+/* Private defines -----------------------------------------------------------*/
+#ifdef SIMULATOR
+#define PROFILE_UNIT    "ns"
+#else
+#define PROFILE_UNIT    "cycles"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static profile_stats_t sections[PROFILE_SECTIONS_NR];
+
+static const char* const section_names[PROFILE_SECTIONS_NR] = {
+    [PROFILE_SNAKE_STEP] = "snake_step",
+    [PROFILE_CHECK_COLLISION] = "snake_check_collision",
+    [PROFILE_DRAW_PART] = "snake_draw_part",
+    [PROFILE_SCREEN_UPDATE] = "nokia5110_present",
+    [PROFILE_PLACE_FOOD] = "snake_place_food",
+    [PROFILE_AUTOPILOT] = "autopilot_decide",
+};
+
+/* Public functions ----------------------------------------------------------*/
+#ifdef SIMULATOR
+/**
+ * @ingroup profile
+ * @brief Reads the monotonic clock.
+ *
+ * @return Nanoseconds, wrapping every 4.29 s like the 32 bits cycle counter.
+ */
+uint32_t profile_now(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+#endif /* SIMULATOR */
+
+/**
+ * @ingroup profile
+ * @brief Starts the cycle counter and clears the statistics.
+ */
+void profile_init(void) {
+#ifndef SIMULATOR
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    profile_reset();
+}
+
+/**
+ * @ingroup profile
+ * @brief Clears the statistics of all sections.
+ */
+void profile_reset(void) {
+    for (uint8_t i = 0; i < PROFILE_SECTIONS_NR; i++) {
+        sections[i].min = UINT32_MAX;
+        sections[i].max = 0;
+        sections[i].total = 0;
+        sections[i].count = 0;
+    }
+}
+
+/**
+ * @ingroup profile
+ * @brief Adds a run to the section statistics.
+ *
+ * @param section   Profiled section.
+ * @param duration  Run duration.
+ */
+void profile_record(profile_section_t section, uint32_t duration) {
+    profile_stats_t* stats = &sections[section];
+
+    if (duration < stats->min) {
+        stats->min = duration;
+    }
+    if (duration > stats->max) {
+        stats->max = duration;
+    }
+    stats->total += duration;
+    stats->count++;
+}
+
+/**
+ * @ingroup profile
+ * @brief Gets the statistics of a section.
+ *
+ * @param section   Profiled section.
+ * @param stats     Output statistics.
+ */
+void profile_get(profile_section_t section, profile_stats_t* stats) {
+    *stats = sections[section];
+}
+
+/**
+ * @ingroup profile
+ * @brief Prints the statistics of all sections with printf.
+ *
+ * On target printf goes through _write (syscalls.c) and __io_putchar.
+ */
+void profile_dump(void) {
+    printf("section                    count        min        max       mean (%s)\r\n", PROFILE_UNIT);
+    for (uint8_t i = 0; i < PROFILE_SECTIONS_NR; i++) {
+        profile_stats_t* stats = &sections[i];
+
+        if (stats->count == 0) {
+            printf("%-24s %7d          -          -          -\r\n", section_names[i], 0);
+            continue;
+        }
+        printf("%-24s %7lu %10lu %10lu %10lu\r\n", section_names[i],
+               (unsigned long)stats->count, (unsigned long)stats->min, (unsigned long)stats->max,
+               (unsigned long)(stats->total / stats->count));
+    }
+}
+
+#endif /* PROFILE_ENABLED */
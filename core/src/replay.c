@@ -0,0 +1,413 @@
+/**
+ * @file
+ * @ingroup replay
+ * @brief Input recording and replay implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "replay.h"
+
+#include "stm32f1xx_hal.h"
+
+#include <string.h>
+
+/* Private types -------------------------------------------------------------*/
+#ifndef SIMULATOR
+/**
+ * @ingroup replay
+ * @brief Header of the log saved in flash, followed by the log.
+ */
+typedef struct {
+    uint32_t magic;     /**< REPLAY_FLASH_MAGIC if a log was saved. */
+    uint16_t size;      /**< Log bytes. */
+    uint16_t checksum;  /**< Sum of the log bytes. */
+} replay_flash_header_t;
+#endif
+
+/* Private defines -----------------------------------------------------------*/
+#define REPLAY_SEED_SIZE    4
+#define REPLAY_VARINT_MAX   5
+
+#define REPLAY_KEY_BITS     2
+#define REPLAY_KEY_MASK     ((1 << REPLAY_KEY_BITS) - 1)
+
+#ifndef SIMULATOR
+#define REPLAY_FLASH_MAGIC  0x594C5052  // "RPLY"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t log_data[REPLAY_LOG_SIZE] = { 0 };
+static uint16_t read_pos = 0;
+static uint32_t last_step = 0;
+
+// Next key of the log, decoded ahead until its step comes
+static uint8_t next_valid = 0;
+static uint32_t next_step = 0;
+static keyboard_key_t next_key = KEYBOARD_KEY_RIGHT;
+
+static replay_status_t status = { 0 };
+
+#ifndef SIMULATOR
+// Flash page reserved in the linker script
+extern const uint8_t _replay_start[];
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void replay_restart(uint32_t seed, uint32_t step);
+static void replay_append(uint32_t step, keyboard_key_t key);
+static uint8_t replay_decode(uint32_t* value);
+#ifndef SIMULATOR
+static uint16_t replay_checksum(const uint8_t* data, uint16_t size);
+static uint8_t replay_flash_write(uint32_t address);
+#endif
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup replay
+ * @brief Starts the log of a new game.
+ *
+ * @param seed  Food generator state at the game start.
+ * @param step  Game step at the game start, the key steps are logged
+ *              from it.
+ */
+static void replay_restart(uint32_t seed, uint32_t step) {
+    status.seed = seed;
+    for (uint8_t i = 0; i < REPLAY_SEED_SIZE; i++) {
+        log_data[i] = (seed >> (8 * i)) & 0xFF;
+    }
+    status.size = REPLAY_SEED_SIZE;
+    status.events = 0;
+    status.overflow = 0;
+    status.games++;
+    last_step = step;
+}
+
+/**
+ * @ingroup replay
+ * @brief Adds a key to the log.
+ *
+ * The key is dropped, and counted as an overflow, if it doesn't fit.
+ *
+ * @param step  Step the key was read at.
+ * @param key   Key read.
+ */
+static void replay_append(uint32_t step, keyboard_key_t key) {
+    uint8_t bytes[REPLAY_VARINT_MAX];
+    uint8_t length = 0;
+    uint32_t value = ((step - last_step) << REPLAY_KEY_BITS) | key;
+
+    do {
+        bytes[length] = value & 0x7F;
+        value >>= 7;
+        if (value != 0) {
+            bytes[length] |= 0x80;
+        }
+        length++;
+    } while (value != 0);
+
+    if (status.size + length > REPLAY_LOG_SIZE) {
+        if (status.overflow < UINT16_MAX) {
+            status.overflow++;
+        }
+        return;
+    }
+
+    memcpy(&log_data[status.size], bytes, length);
+    status.size += length;
+    status.events++;
+    last_step = step;
+}
+
+/**
+ * @ingroup replay
+ * @brief Reads the next varint of the log.
+ *
+ * @param value Output value.
+ *
+ * @return 1 if a value was read, 0 at the end of the log.
+ */
+static uint8_t replay_decode(uint32_t* value) {
+    uint32_t result = 0;
+
+    for (uint8_t shift = 0; shift < 7 * REPLAY_VARINT_MAX; shift += 7) {
+        if (read_pos >= status.size) {
+            return 0;
+        }
+
+        uint8_t byte = log_data[read_pos++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#ifndef SIMULATOR
+/**
+ * @ingroup replay
+ * @brief Sums the log bytes, to tell a saved log from a partly written one.
+ */
+static uint16_t replay_checksum(const uint8_t* data, uint16_t size) {
+    uint16_t sum = 0;
+
+    for (uint16_t i = 0; i < size; i++) {
+        sum += data[i];
+    }
+
+    return sum;
+}
+
+/**
+ * @ingroup replay
+ * @brief Erases the flash page and writes the log, then its header.
+ *
+ * The flash must be unlocked.
+ *
+ * @param address   Page address.
+ *
+ * @return 1 on success, 0 otherwise.
+ */
+static uint8_t replay_flash_write(uint32_t address) {
+    FLASH_EraseInitTypeDef erase = { 0 };
+    uint32_t page_error = 0;
+
+    replay_flash_header_t header = {
+        .magic = REPLAY_FLASH_MAGIC,
+        .size = status.size,
+        .checksum = replay_checksum(log_data, status.size),
+    };
+
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = address;
+    erase.NbPages = 1;
+    if (HAL_FLASHEx_Erase(&erase, &page_error) != HAL_OK) {
+        return 0;
+    }
+
+    // Half word writes, the last odd byte is padded with the erased value
+    for (uint16_t i = 0; i < status.size; i += 2) {
+        uint16_t half = log_data[i];
+
+        half |= (i + 1 < status.size) ? (log_data[i + 1] << 8) : 0xFF00;
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + sizeof(header) + i, half) != HAL_OK) {
+            return 0;
+        }
+    }
+
+    const uint16_t* halves = (const uint16_t*)&header;
+    for (uint8_t i = 0; i < sizeof(header) / 2; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + 2 * i, halves[i]) != HAL_OK) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+#endif
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup replay
+ * @brief Starts recording.
+ *
+ * The game must be seeded with the same seed and restarted right after
+ * (see @ref snake_seed). The log restarts at each new game, see
+ * @ref replay_input.
+ *
+ * @param seed  Food seed of the game.
+ */
+void replay_record(uint32_t seed) {
+    memset(&status, 0, sizeof(status));
+    status.mode = REPLAY_RECORDING;
+    replay_restart(seed, 0);
+}
+
+/**
+ * @ingroup replay
+ * @brief Starts playing a log.
+ *
+ * The game must be seeded with the log seed (see @ref replay_get_status)
+ * and restarted right after.
+ *
+ * @param log   Log, copied to RAM.
+ * @param size  Log bytes.
+ *
+ * @return 1 on success, 0 if the log doesn't fit or has no seed.
+ */
+uint8_t replay_play(const uint8_t* log, uint16_t size) {
+    if (size < REPLAY_SEED_SIZE || size > REPLAY_LOG_SIZE) {
+        return 0;
+    }
+
+    memmove(log_data, log, size);
+
+    memset(&status, 0, sizeof(status));
+    status.mode = REPLAY_PLAYING;
+    status.size = size;
+    for (uint8_t i = 0; i < REPLAY_SEED_SIZE; i++) {
+        status.seed |= (uint32_t)log_data[i] << (8 * i);
+    }
+
+    read_pos = REPLAY_SEED_SIZE;
+    last_step = 0;
+    next_valid = 0;
+
+    return 1;
+}
+
+/**
+ * @ingroup replay
+ * @brief Goes back to reading the keyboard without recording.
+ *
+ * The log is kept, so it can still be saved.
+ */
+void replay_stop(void) {
+    status.mode = REPLAY_IDLE;
+}
+
+/**
+ * @ingroup replay
+ * @brief Checks if the keys come from the log.
+ *
+ * The game never waits for the keyboard then, so the MCU mustn't stop.
+ *
+ * @return 1 if playing, 0 otherwise.
+ */
+uint8_t replay_is_playing(void) {
+    return (status.mode == REPLAY_PLAYING);
+}
+
+/**
+ * @ingroup replay
+ * @brief Game input, see @ref snake_input_t.
+ *
+ * Reads the keyboard, recording the key when recording, or takes the
+ * next key of the log when its step comes. The keyboard is read again
+ * once the whole log was played.
+ *
+ * When recording, the log restarts with the food generator state and
+ * the step of each new game, when the game drops the queued keys.
+ *
+ * @param game  Game, its step is counted from @ref snake_seed.
+ * @param key   Output key, NULL to drop the queued keyboard keys.
+ *
+ * @return 1 if a key was read, 0 otherwise.
+ */
+uint8_t replay_input(snake_game_t* game, keyboard_key_t* key) {
+    uint32_t step = game->step;
+
+    if (key == NULL) {
+        keyboard_clear();
+        if (status.mode == REPLAY_RECORDING && game->state == SNAKE_STATE_PLAYING) {
+            replay_restart(game->prng.state, step);
+        }
+        return 0;
+    }
+
+    if (status.mode == REPLAY_PLAYING) {
+        if (next_valid == 0) {
+            uint32_t value;
+
+            if (replay_decode(&value) == 0) {
+                // The player takes over
+                status.done = 1;
+                status.mode = REPLAY_IDLE;
+                return replay_input(game, key);
+            }
+
+            next_step = last_step + (value >> REPLAY_KEY_BITS);
+            next_key = value & REPLAY_KEY_MASK;
+            next_valid = 1;
+        }
+
+        if (next_step > step) {
+            return 0;
+        }
+
+        *key = next_key;
+        last_step = next_step;
+        next_valid = 0;
+        status.events++;
+        return 1;
+    }
+
+    keyboard_event_t event;
+
+    if (keyboard_read(&event) == 0) {
+        return 0;
+    }
+
+    *key = event.key;
+    if (status.mode == REPLAY_RECORDING && game->state == SNAKE_STATE_PLAYING) {
+        replay_append(step, event.key);
+    }
+
+    return 1;
+}
+
+/**
+ * @ingroup replay
+ * @brief Gets the log.
+ *
+ * @param log   Output log pointer.
+ *
+ * @return Log bytes.
+ */
+uint16_t replay_get_log(const uint8_t** log) {
+    *log = log_data;
+    return status.size;
+}
+
+/**
+ * @ingroup replay
+ * @brief Gets the replay status.
+ *
+ * @param output    Output status.
+ */
+void replay_get_status(replay_status_t* output) {
+    *output = status;
+}
+
+#ifndef SIMULATOR
+/**
+ * @ingroup replay
+ * @brief Saves the log to the reserved flash page.
+ *
+ * The header is written last, so a reset in between leaves no log.
+ * Takes about 30 ms, and each save wears the page (10k cycles), so it
+ * should only run on the idle screens of debug builds (see
+ * REPLAY_SAVE_TO_FLASH).
+ *
+ * @return 1 on success, 0 otherwise.
+ */
+uint8_t replay_flash_save(void) {
+    HAL_FLASH_Unlock();
+    uint8_t result = replay_flash_write((uint32_t)_replay_start);
+    HAL_FLASH_Lock();
+
+    return result;
+}
+
+/**
+ * @ingroup replay
+ * @brief Plays the log saved in the reserved flash page.
+ *
+ * @return 1 if a valid log was found, 0 otherwise.
+ */
+uint8_t replay_flash_load(void) {
+    const replay_flash_header_t* header = (const replay_flash_header_t*)_replay_start;
+    const uint8_t* log = _replay_start + sizeof(*header);
+
+    if (header->magic != REPLAY_FLASH_MAGIC || header->size > REPLAY_LOG_SIZE) {
+        return 0;
+    }
+
+    if (replay_checksum(log, header->size) != header->checksum) {
+        return 0;
+    }
+
+    return replay_play(log, header->size);
+}
+#endif
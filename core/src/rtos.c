@@ -0,0 +1,431 @@
+/**
+ * @file
+ * @ingroup rtos
+ * @brief FreeRTOS build variant implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "rtos.h"
+
+#if (RTOS_ENABLED == 1)
+
+#include "keyboard.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "autopilot.h"
+#include "nokia5110.h"
+
+#include "stm32f1xx_hal.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Private defines -----------------------------------------------------------*/
+// Interrupts that notify the tasks, below configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define RTOS_DISPLAY_IRQ            DMA1_Channel3_IRQn
+#define RTOS_DISPLAY_IRQ_PRIORITY   5
+#define RTOS_KEYS_IRQ               EXTI15_10_IRQn
+#define RTOS_KEYS_IRQ_PRIORITY      6
+
+#define RTOS_RUNTIME_TIM_INSTANCE   TIM2
+#define RTOS_RUNTIME_TIM_CLOCK_EN() __HAL_RCC_TIM2_CLK_ENABLE()
+
+#define RTOS_STEP_TICKS             pdMS_TO_TICKS(1000 / SCHEDULER_STEP_HZ)
+#define RTOS_DUMP_PERIOD_TICKS      pdMS_TO_TICKS(10000)
+
+// Display task notification bits
+#define RTOS_EVENT_FRAME_READY      (1U << 0)
+#define RTOS_EVENT_FRAME_SENT       (1U << 1)
+
+// Idle and stats tasks included
+#define RTOS_TASKS_NR               5
+
+/* Private variables ---------------------------------------------------------*/
+static snake_game_t* displayed_game = NULL;
+static snake_input_t game_input = NULL;
+
+static StaticTask_t input_tcb;
+static StaticTask_t display_tcb;
+static StaticTask_t game_tcb;
+static StaticTask_t idle_tcb;
+static StackType_t input_stack[RTOS_INPUT_STACK];
+static StackType_t display_stack[RTOS_DISPLAY_STACK];
+static StackType_t game_stack[RTOS_GAME_STACK];
+static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+#if (PROFILE_ENABLED == 1)
+static StaticTask_t stats_tcb;
+static StackType_t stats_stack[RTOS_STATS_STACK];
+#endif
+
+static TaskHandle_t input_task = NULL;
+static TaskHandle_t display_task = NULL;
+static TaskHandle_t game_task = NULL;
+
+static StaticSemaphore_t frame_taken_buffer;
+static SemaphoreHandle_t frame_taken = NULL;
+
+static TIM_HandleTypeDef runtime_tim = { 0 };
+static uint16_t runtime_last = 0;
+static uint32_t runtime_count = 0;
+
+static uint32_t frames = 0;
+static uint32_t steps = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void rtos_runtime_init(void);
+static void rtos_present(snake_game_t* game);
+static void rtos_input_task(void* argument);
+static void rtos_display_task(void* argument);
+static void rtos_game_task(void* argument);
+#if (PROFILE_ENABLED == 1)
+static void rtos_stats_task(void* argument);
+#endif
+
+// Port SysTick handler (port.c), not in the kernel headers
+void xPortSysTickHandler(void);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup rtos
+ * @brief Starts TIM2 as the free running run time counter.
+ */
+static void rtos_runtime_init(void) {
+    RTOS_RUNTIME_TIM_CLOCK_EN();
+
+    runtime_tim.Instance = RTOS_RUNTIME_TIM_INSTANCE;
+    runtime_tim.Init.Prescaler = scheduler_timer_clock() / RTOS_RUNTIME_HZ - 1;
+    runtime_tim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    runtime_tim.Init.Period = UINT16_MAX;
+    runtime_tim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    runtime_tim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&runtime_tim);
+    HAL_TIM_Base_Start(&runtime_tim);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Game present hook, see @ref snake_present_t.
+ *
+ * Hands the frame to the display task and waits for it to be taken, so
+ * the game doesn't draw over it.
+ */
+static void rtos_present(snake_game_t* game) {
+    (void)game;
+
+    xTaskNotify(display_task, RTOS_EVENT_FRAME_READY, eSetBits);
+    xSemaphoreTake(frame_taken, portMAX_DELAY);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Input task, polls the keys into the keyboard queue.
+ *
+ * Sleeps until a key edge. In polling mode, keeps sampling the keys
+ * while they settle, are held or their presses are queued.
+ */
+static void rtos_input_task(void* argument) {
+    (void)argument;
+
+    while (1) {
+#if (KEYBOARD_USE_EXTI == 1)
+        TickType_t timeout = portMAX_DELAY;
+#else
+        TickType_t timeout = (keyboard_is_idle() != 0) ? portMAX_DELAY : pdMS_TO_TICKS(KEYBOARD_SAMPLE_MS);
+#endif
+
+        ulTaskNotifyTake(pdTRUE, timeout);
+        keyboard_poll();
+
+        // Wakes up the game waiting on the idle screens
+        if (keyboard_pending() != 0) {
+            xTaskNotifyGive(game_task);
+        }
+    }
+}
+
+/**
+ * @ingroup rtos
+ * @brief Display task, presents the frames drawn by the game task.
+ *
+ * A frame is presented once the previous DMA transfer is done, so the
+ * task never waits for the display driver.
+ */
+static void rtos_display_task(void* argument) {
+    uint32_t events = 0;
+
+    (void)argument;
+
+    while (1) {
+        uint32_t notified = 0;
+
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+        events |= notified;
+
+        if ((events & RTOS_EVENT_FRAME_READY) != 0 && nokia5110_is_busy() == 0) {
+            PROFILE_START(PROFILE_SCREEN_UPDATE);
+            nokia5110_present();
+            PROFILE_END(PROFILE_SCREEN_UPDATE);
+
+            frames++;
+            events = 0;
+            xSemaphoreGive(frame_taken);
+        }
+        events &= RTOS_EVENT_FRAME_READY;
+    }
+}
+
+/**
+ * @ingroup rtos
+ * @brief Game task, steps the game at SCHEDULER_STEP_HZ.
+ *
+ * On the game over and win screens, keeps the game in flash (with
+ * REPLAY_SAVE_TO_FLASH = 1) and blocks until a key is pressed, unless
+ * the replay or the autopilot plays. The input task notifies each key
+ * press, so the count left from the keys read while playing is cleared
+ * first.
+ */
+static void rtos_game_task(void* argument) {
+#if (REPLAY_SAVE_TO_FLASH == 1)
+    replay_status_t replay;
+    uint16_t replay_saved_game = 0;
+#endif
+
+    (void)argument;
+
+    TickType_t wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&wake, RTOS_STEP_TICKS);
+        snake_step(displayed_game, game_input);
+        steps++;
+
+        if (snake_is_idle(displayed_game) == 0) {
+            continue;
+        }
+
+#if (REPLAY_SAVE_TO_FLASH == 1)
+        // Keeps the last game in flash on its game over screen, for bug reports
+        replay_get_status(&replay);
+        if (replay.mode == REPLAY_RECORDING && replay.games != replay_saved_game) {
+            replay_flash_save();
+            replay_saved_game = replay.games;
+        }
+#endif
+
+        // Nothing to draw until a key is pressed, the autopilot never waits.
+        // A key pressed after the clear is still counted and wakes the task.
+        ulTaskNotifyValueClear(NULL, UINT32_MAX);
+        if (AUTOPILOT_ENABLED == 0 && replay_is_playing() == 0 && keyboard_is_idle() != 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            wake = xTaskGetTickCount();
+        }
+    }
+}
+
+#if (PROFILE_ENABLED == 1)
+/**
+ * @ingroup rtos
+ * @brief Stats task, prints the profiling and task statistics.
+ */
+static void rtos_stats_task(void* argument) {
+    (void)argument;
+
+    TickType_t wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&wake, RTOS_DUMP_PERIOD_TICKS);
+
+        profile_dump();
+        rtos_dump_stats();
+        printf("keys dropped %lu\r\n", keyboard_dropped());
+    }
+}
+#endif
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup rtos
+ * @brief Creates the tasks and starts the scheduler. Never returns.
+ *
+ * The keyboard, the display and the game must be set up before. The
+ * game frames are sent by the display task from then on.
+ *
+ * @param displayed Displayed game, started before (see @ref snake_init).
+ * @param input     Game key source, see @ref snake_input_t.
+ */
+void rtos_start(snake_game_t* displayed, snake_input_t input) {
+    displayed_game = displayed;
+    game_input = input;
+
+    rtos_runtime_init();
+
+    HAL_NVIC_SetPriority(RTOS_DISPLAY_IRQ, RTOS_DISPLAY_IRQ_PRIORITY, 0);
+    HAL_NVIC_SetPriority(RTOS_KEYS_IRQ, RTOS_KEYS_IRQ_PRIORITY, 0);
+
+    frame_taken = xSemaphoreCreateBinaryStatic(&frame_taken_buffer);
+
+    input_task = xTaskCreateStatic(rtos_input_task, "input", RTOS_INPUT_STACK, NULL,
+                                   RTOS_INPUT_PRIORITY, input_stack, &input_tcb);
+    display_task = xTaskCreateStatic(rtos_display_task, "display", RTOS_DISPLAY_STACK, NULL,
+                                     RTOS_DISPLAY_PRIORITY, display_stack, &display_tcb);
+    game_task = xTaskCreateStatic(rtos_game_task, "game", RTOS_GAME_STACK, NULL,
+                                  RTOS_GAME_PRIORITY, game_stack, &game_tcb);
+#if (PROFILE_ENABLED == 1)
+    xTaskCreateStatic(rtos_stats_task, "stats", RTOS_STATS_STACK, NULL,
+                      RTOS_STATS_PRIORITY, stats_stack, &stats_tcb);
+#endif
+
+    // The display task sends the frames from now on
+    displayed->present = rtos_present;
+
+    vTaskStartScheduler();
+
+    // Only gets here if the kernel couldn't start
+    while (1);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Prints the priority, the stack high water mark and the share
+ * of run time of each task, and the frame and step counts.
+ *
+ * The high water mark is the least free stack space seen so far.
+ */
+void rtos_dump_stats(void) {
+    TaskStatus_t tasks[RTOS_TASKS_NR];
+    uint32_t total = 0;
+
+    UBaseType_t task_nr = uxTaskGetSystemState(tasks, RTOS_TASKS_NR, &total);
+    if (total == 0) {
+        total = 1;
+    }
+
+    printf("task     prio  stack free  run\r\n");
+    for (UBaseType_t i = 0; i < task_nr; i++) {
+        uint32_t permille = (uint64_t)tasks[i].ulRunTimeCounter * 1000 / total;
+
+        printf("%-8s %4lu %7lu B %3lu.%lu%%\r\n", tasks[i].pcTaskName,
+               (uint32_t)tasks[i].uxCurrentPriority,
+               (uint32_t)tasks[i].usStackHighWaterMark * sizeof(StackType_t),
+               permille / 10, permille % 10);
+    }
+    printf("frames %lu, steps %lu, run time %lu ms\r\n", frames, steps, total / (RTOS_RUNTIME_HZ / 1000));
+}
+
+/**
+ * @ingroup rtos
+ * @brief Runs the kernel tick. Must be called from the SysTick handler.
+ */
+void rtos_tick_handler(void) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        xPortSysTickHandler();
+    }
+}
+
+/**
+ * @ingroup rtos
+ * @brief Gets the run time counter, in 1 / RTOS_RUNTIME_HZ.
+ *
+ * Extends the 16 bit TIM2 counter, so it must be read within one timer
+ * wrap (6.5 s), which the idle hook and the context switches do. A
+ * tickless sleep longer than that on the idle screens loses the extra
+ * wraps, from the idle time only. Called by the kernel from task and
+ * interrupt context.
+ */
+uint32_t rtos_runtime_counter(void) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    uint16_t now = __HAL_TIM_GET_COUNTER(&runtime_tim);
+    runtime_count += (uint16_t)(now - runtime_last);
+    runtime_last = now;
+
+    uint32_t count = runtime_count;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    return count;
+}
+
+/**
+ * @ingroup rtos
+ * @brief Steps the HAL tick forward by the ticks slept through.
+ *
+ * Called by the kernel after a tickless sleep, so HAL_GetTick keeps
+ * counting the time (key debouncing, timeouts).
+ */
+void rtos_step_hal_tick(uint32_t ticks) {
+    uwTick += ticks;
+}
+
+/**
+ * @ingroup rtos
+ * @brief Display update completed callback, wakes up the display task.
+ *
+ * Called from the DMA interrupt, or from the display task itself when
+ * there was nothing to send.
+ */
+void nokia5110_update_cplt_callback(void) {
+    BaseType_t woken = pdFALSE;
+
+    if (display_task == NULL) {
+        return;
+    }
+
+    if (__get_IPSR() == 0) {
+        xTaskNotify(display_task, RTOS_EVENT_FRAME_SENT, eSetBits);
+        return;
+    }
+
+    xTaskNotifyFromISR(display_task, RTOS_EVENT_FRAME_SENT, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Key edge callback, wakes up the input task.
+ */
+void keyboard_edge_callback(void) {
+    BaseType_t woken = pdFALSE;
+
+    if (input_task == NULL) {
+        return;
+    }
+
+    vTaskNotifyGiveFromISR(input_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Kernel idle hook, keeps the run time counter up to date.
+ */
+void vApplicationIdleHook(void) {
+    (void)rtos_runtime_counter();
+}
+
+/**
+ * @ingroup rtos
+ * @brief Kernel stack overflow hook.
+ */
+void vApplicationStackOverflowHook(TaskHandle_t task, char* name) {
+    (void)task;
+    (void)name;
+
+    taskDISABLE_INTERRUPTS();
+    while (1);
+}
+
+/**
+ * @ingroup rtos
+ * @brief Gives the kernel the idle task memory (static allocation).
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t** tcb, StackType_t** stack, configSTACK_DEPTH_TYPE* stack_size) {
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_size = configMINIMAL_STACK_SIZE;
+}
+
+#endif /* RTOS_ENABLED */
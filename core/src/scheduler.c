@@ -0,0 +1,256 @@
+/**
+ * @file
+ * @ingroup scheduler
+ * @brief Game tick scheduler implementation.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "scheduler.h"
+#include "power.h"
+#include "keyboard.h"
+
+#include "stm32f1xx_hal.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SCHEDULER_TIM_INSTANCE      TIM2
+#define SCHEDULER_TIM_CLOCK_EN()    __HAL_RCC_TIM2_CLK_ENABLE()
+#define SCHEDULER_TIM_IRQ           TIM2_IRQn
+#define SCHEDULER_TIM_IRQ_PRIORITY  2
+
+#if (KEYBOARD_USE_EXTI == 1)
+// Interrupts at the step rate, the 16 bits counter counts 20 us so 1 Hz fits
+#define SCHEDULER_COUNTER_HZ        50000
+#else
+// Interrupts at SCHEDULER_BASE_HZ to poll the keys, the counter counts microseconds
+#define SCHEDULER_COUNTER_HZ        1000000
+#endif
+#define SCHEDULER_US_PER_COUNT      (1000000 / SCHEDULER_COUNTER_HZ)
+
+/* Private variables ---------------------------------------------------------*/
+static TIM_HandleTypeDef tim_handle = { 0 };
+
+static volatile uint32_t base_us = 0;
+static uint32_t tick_us = 1000000 / SCHEDULER_BASE_HZ;
+static uint16_t tick_hz = SCHEDULER_BASE_HZ;
+static volatile uint8_t step_pending = 0;
+static volatile uint32_t step_due_us = 0;
+static uint16_t step_rate = SCHEDULER_STEP_HZ;
+static uint16_t step_accumulator = 0;
+
+static volatile scheduler_stats_t stats = { 0 };
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup scheduler
+ * @brief Starts the base tick timer.
+ *
+ * @param step_hz   Game steps per second (from 1 to SCHEDULER_BASE_HZ).
+ */
+void scheduler_init(uint16_t step_hz) {
+    scheduler_set_rate(step_hz);
+    scheduler_reset_stats();
+
+    SCHEDULER_TIM_CLOCK_EN();
+
+    tim_handle.Instance = SCHEDULER_TIM_INSTANCE;
+    tim_handle.Init.Prescaler = scheduler_timer_clock() / SCHEDULER_COUNTER_HZ - 1;
+    tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    tim_handle.Init.Period = tick_us / SCHEDULER_US_PER_COUNT - 1;
+    tim_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    tim_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&tim_handle);
+
+    HAL_NVIC_SetPriority(SCHEDULER_TIM_IRQ, SCHEDULER_TIM_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(SCHEDULER_TIM_IRQ);
+
+    HAL_TIM_Base_Start_IT(&tim_handle);
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Changes the game step rate.
+ *
+ * The accumulator restarts, so the next step is a full period away. In
+ * EXTI mode the timer period is the step period, and restarts too.
+ *
+ * @param step_hz   Game steps per second (from 1 to SCHEDULER_BASE_HZ).
+ */
+void scheduler_set_rate(uint16_t step_hz) {
+    if (step_hz == 0) {
+        step_hz = 1;
+    } else if (step_hz > SCHEDULER_BASE_HZ) {
+        step_hz = SCHEDULER_BASE_HZ;
+    }
+
+    __disable_irq();
+    step_rate = step_hz;
+    step_accumulator = 0;
+#if (KEYBOARD_USE_EXTI == 1)
+    tick_hz = step_hz;
+    tick_us = (SCHEDULER_COUNTER_HZ / step_hz) * SCHEDULER_US_PER_COUNT;
+    if (tim_handle.Instance != NULL) {
+        base_us += __HAL_TIM_GET_COUNTER(&tim_handle) * SCHEDULER_US_PER_COUNT;
+        __HAL_TIM_SET_AUTORELOAD(&tim_handle, tick_us / SCHEDULER_US_PER_COUNT - 1);
+        __HAL_TIM_SET_COUNTER(&tim_handle, 0);
+    }
+#endif
+    __enable_irq();
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Sleeps until the next base tick.
+ *
+ * Interrupts are disabled around the check so a tick between the check
+ * and the sleep (@ref power_sleep) still wakes the core. Other interrupts (the display DMA)
+ * also wake it, and the wait goes on until the tick.
+ */
+void scheduler_wait(void) {
+    uint32_t tick = base_us;
+
+    while (base_us == tick) {
+        __disable_irq();
+        if (base_us == tick) {
+            power_sleep();
+        }
+        __enable_irq();
+    }
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Checks if a game step is due and takes it.
+ *
+ * Updates the step count and latency statistics.
+ *
+ * @return 1 if the caller must run a step, 0 otherwise.
+ */
+uint8_t scheduler_step_due(void) {
+    if (step_pending == 0) {
+        return 0;
+    }
+
+    __disable_irq();
+    step_pending = 0;
+    uint32_t due_us = step_due_us;
+    __enable_irq();
+
+    uint32_t latency = scheduler_now_us() - due_us;
+
+    if (latency < stats.latency_min_us) {
+        stats.latency_min_us = latency;
+    }
+    if (latency > stats.latency_max_us) {
+        stats.latency_max_us = latency;
+    }
+    stats.steps++;
+
+    return 1;
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Gets the time since the scheduler started.
+ *
+ * Must not be called with interrupts disabled, since a pending base
+ * tick would be missed.
+ *
+ * @return Microseconds, wrapping every 71 minutes.
+ */
+uint32_t scheduler_now_us(void) {
+    uint32_t tick;
+    uint32_t counter;
+
+    // Reads again if a base tick happened in between
+    do {
+        tick = base_us;
+        counter = __HAL_TIM_GET_COUNTER(&tim_handle);
+    } while (tick != base_us);
+
+    return tick + counter * SCHEDULER_US_PER_COUNT;
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Gets the APB1 timers clock.
+ *
+ * The timers run at PCLK1, or twice PCLK1 when APB1 is divided (see
+ * the RCC clock tree).
+ *
+ * @return Timer clock in Hz.
+ */
+uint32_t scheduler_timer_clock(void) {
+    RCC_ClkInitTypeDef clk_init;
+    uint32_t flash_latency;
+
+    HAL_RCC_GetClockConfig(&clk_init, &flash_latency);
+    if (clk_init.APB1CLKDivider == RCC_HCLK_DIV1) {
+        return HAL_RCC_GetPCLK1Freq();
+    }
+    return HAL_RCC_GetPCLK1Freq() * 2;
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Gets the scheduler statistics.
+ *
+ * @param output    Output statistics.
+ */
+void scheduler_get_stats(scheduler_stats_t* output) {
+    __disable_irq();
+    *output = stats;
+    __enable_irq();
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Clears the scheduler statistics.
+ */
+void scheduler_reset_stats(void) {
+    __disable_irq();
+    stats.steps = 0;
+    stats.overruns = 0;
+    stats.latency_min_us = UINT32_MAX;
+    stats.latency_max_us = 0;
+    __enable_irq();
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Handles the base tick timer interrupt.
+ *
+ * Must be called from the TIM2 IRQ handler.
+ */
+void scheduler_irq_handler(void) {
+    HAL_TIM_IRQHandler(&tim_handle);
+}
+
+/**
+ * @ingroup scheduler
+ * @brief Timer period elapsed callback (base tick).
+ *
+ * Makes a step due when the accumulator reaches the tick rate, at each
+ * tick in EXTI mode. If
+ * the previous step is still pending it's counted as an overrun and
+ * dropped, so a late game doesn't run a burst of steps to catch up.
+ *
+ * @param htim  Timer handle.
+ */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
+    if (htim != &tim_handle) {
+        return;
+    }
+
+    base_us += tick_us;
+
+    step_accumulator += step_rate;
+    if (step_accumulator < tick_hz) {
+        return;
+    }
+    step_accumulator -= tick_hz;
+
+    if (step_pending != 0) {
+        stats.overruns++;
+    }
+    step_pending = 1;
+    step_due_us = base_us;
+}
@@ -8,179 +8,242 @@
  */
 /* Includes ------------------------------------------------------------------*/
 #include "snake.h"
+#include "snake_lut.h"
 
 #include "nokia5110.h"
+#include "profile.h"
+#include "keyboard.h"
+#include "prng.h"
 
 #include "stm32f1xx_hal.h"
 
-#include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Private types -------------------------------------------------------------*/
 /**
  * @ingroup snake
- * @brief Moving directions.
+ * @brief Collision state.
  */
 typedef enum {
-    SNAKE_DIR_RIGHT = 0,    /**< Snake moving right. */
-    SNAKE_DIR_DOWN,         /**< Snake moving down. */
-    SNAKE_DIR_LEFT,         /**< Snake moving left. */
-    SNAKE_DIR_UP,           /**< Snake moving up. */
-} snake_dir_t;
+    SNAKE_COLLISION_FALSE = 0,  /**< The point doesn`t colide with a snake part. */
+    SNAKE_COLLISION_TRUE,       /**< The point colides with a snake part. */
+} snake_collision_t;
 
-/**
- * @ingroup snake
- * @brief Keyboard keys.
- */
-typedef enum {
-    SNAKE_KEY_NONE = 0, /**< No key pressed. */
-    SNAKE_KEY_RIGHT,    /**< Right pressed. */
-    SNAKE_KEY_DOWN,     /**< Down pressed. */
-    SNAKE_KEY_LEFT,     /**< Left pressed. */
-    SNAKE_KEY_UP,       /**< Up pressed. */
-} snake_key_t;
+/* Private defines -----------------------------------------------------------*/
+// Define as 1 to draw the snake with 3 pixels width
+#define SNAKE_THINNER   0
 
+#define SNAKE_INIT_FOOD_X   (SNAKE_MAX_X / 2)
+#define SNAKE_INIT_FOOD_Y   (SNAKE_MAX_Y / 2)
+#define SNAKE_INIT_SIZE     3
+
+// Text position of the end messages, from the board origin
+#define SNAKE_TEXT_X    6
+#define SNAKE_TEXT_LINE 2
+#define SNAKE_SCORE_X   52
+
+// Board geometry checks, see snake.h
+#if (SNAKE_PART_SIZE != 2) && (SNAKE_PART_SIZE != 4) && (SNAKE_PART_SIZE != 8)
+#error "SNAKE_PART_SIZE must be 2, 4 or 8"
+#endif
+
+#if (SNAKE_BOARD_WIDTH > NOKIA5110_MAX_COL_NR) || (SNAKE_BOARD_HEIGHT > NOKIA5110_MAX_LINE_NR * 8)
+#error "the board doesn't fit in the display"
+#endif
+
+#if (SNAKE_MAX_X < SNAKE_INIT_SIZE) || (SNAKE_MAX_Y < 1)
+#error "the board is too small for the initial snake"
+#endif
+
+_Static_assert((snake_cell_t)SNAKE_CELLS == SNAKE_CELLS, "snake_cell_t can't count the cells");
+_Static_assert((snake_index_t)(SNAKE_MAX_SIZE - 1) == SNAKE_MAX_SIZE - 1, "snake_index_t can't index the body ring");
+_Static_assert(SNAKE_MAX_SIZE >= SNAKE_CELLS, "the body ring can't hold a snake filling the board");
+_Static_assert(SNAKE_CELLS <= 999, "the end screen shows 3 score digits");
+
+// The cell tables are generated for this geometry (tools/gen_cell_lut.py)
+#if !defined(SNAKE_LUT_MAX_X)
+#error "snake_lut.h has no tables for this board, run tools/gen_cell_lut.py"
+#elif (SNAKE_LUT_MAX_X != SNAKE_MAX_X) || (SNAKE_LUT_MAX_Y != SNAKE_MAX_Y) || (SNAKE_LUT_PART_SIZE != SNAKE_PART_SIZE) || \
+    (SNAKE_LUT_X_0 != SNAKE_X_0) || (SNAKE_LUT_Y_0 != SNAKE_Y_0)
+#error "snake_lut.h doesn't match the board geometry, run tools/gen_cell_lut.py"
+#endif
+
+// screen_buffer offset of the board origin, which is on a line boundary
+#define SNAKE_ORIGIN_OFFSET(game)   (((game)->y0 / 8) * NOKIA5110_MAX_COL_NR + (game)->x0)
+
+// Food glyph size (in pixels)
+#if (SNAKE_PART_SIZE == 2)
+#define SNAKE_FOOD_WIDTH    2
+#define SNAKE_FOOD_HEIGHT   2
+#elif (SNAKE_PART_SIZE == 4)
+#define SNAKE_FOOD_WIDTH    3
+#define SNAKE_FOOD_HEIGHT   4
+#else
+#define SNAKE_FOOD_WIDTH    7
+#define SNAKE_FOOD_HEIGHT   7
+#endif
+
+
+/* Private variables ---------------------------------------------------------*/
+// Food glyph, a diamond the cell size (display layout, LSB on top)
+#if (SNAKE_PART_SIZE == 2)
+static const uint8_t food_glyph[SNAKE_FOOD_WIDTH] = { 0x01, 0x02 };
+#elif (SNAKE_PART_SIZE == 4)
+static const uint8_t food_glyph[SNAKE_FOOD_WIDTH] = { 0x04, 0x0A, 0x04 };
+#else
+static const uint8_t food_glyph[SNAKE_FOOD_WIDTH] = { 0x08, 0x14, 0x22, 0x41, 0x22, 0x14, 0x08 };
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void snake_occupy(snake_game_t* game, snake_cell_t cell);
+static void snake_vacate(snake_game_t* game, snake_cell_t cell);
+static uint8_t snake_place_food(snake_game_t* game);
+static snake_collision_t snake_check_collision(const snake_game_t* game, snake_cell_t cell);
+static void snake_draw_part(const snake_game_t* game, snake_cell_t cell);
+static void snake_erase_part(const snake_game_t* game, snake_cell_t cell);
+static snake_cell_t snake_next_cell(snake_cell_t cell, snake_dir_t direction);
+static void snake_draw_food(const snake_game_t* game);
+static void snake_draw_board(snake_game_t* game);
+static void snake_draw_end(snake_game_t* game);
+static void snake_present(snake_game_t* game, uint8_t blocking);
+static uint8_t snake_keyboard_input(snake_game_t* game, keyboard_key_t* key);
+static snake_dir_t snake_next_direction(snake_game_t* game, snake_input_t input);
+
+/* Private function implementation--------------------------------------------*/
 /**
  * @ingroup snake
- * @brief Game states.
+ * @brief Marks a board cell as covered by the snake.
+ *
+ * Removes the cell from the free cells, moving the last free cell to
+ * its slot.
+ *
+ * @param game  Game.
+ * @param cell  Cell of the new snake part.
  */
-typedef enum {
-    SNAKE_STATE_PLAYING = 0,  /**< Playing the game. */
-    SNAKE_STATE_GAME_OVER,    /**< Game over! */
-    SNAKE_STATE_WIN,          /**< You win! */
-} snake_state_t;
+static void snake_occupy(snake_game_t* game, snake_cell_t cell) {
+    snake_cell_t slot = game->free_slot[cell];
+    snake_cell_t last = game->free_cells[--game->free_cell_nr];
+
+    game->free_cells[slot] = last;
+    game->free_slot[last] = slot;
+    game->free_cells[game->free_cell_nr] = cell;
+    game->free_slot[cell] = game->free_cell_nr;
+}
 
 /**
  * @ingroup snake
- * @brief Collision state.
+ * @brief Marks a board cell as free.
+ *
+ * Swaps the cell with the first covered one and grows the free cells
+ * over it.
+ *
+ * @param game  Game.
+ * @param cell  Cell of the removed snake part.
  */
-typedef enum {
-    SNAKE_COLLISION_FALSE = 0,  /**< The point doesn`t colide with a snake part. */
-    SNAKE_COLLISION_TRUE,       /**< The point colides with a snake part. */
-} snake_collision_t;
+static void snake_vacate(snake_game_t* game, snake_cell_t cell) {
+    snake_cell_t slot = game->free_slot[cell];
+    snake_cell_t first = game->free_cells[game->free_cell_nr];
+
+    game->free_cells[slot] = first;
+    game->free_slot[first] = slot;
+    game->free_cells[game->free_cell_nr] = cell;
+    game->free_slot[cell] = game->free_cell_nr++;
+}
 
 /**
  * @ingroup snake
- * @brief Game coordinates.
+ * @brief Puts the food on a random free cell.
+ *
+ * Takes a single draw over the free cells, so it always takes the same
+ * time whatever the snake size.
+ *
+ * @param game  Game.
  *
- * The game coordinates must be inside the following range:
- * x = (0, 20), y = (0, 11)
+ * @return 1 if the food was placed, 0 if the board is full.
  */
-typedef struct {
-    uint8_t x;  /**< X coordinate (column). */
-    uint8_t y;  /**< Y coordinate (line). */
-} snake_pos_t;
-
-/* Private defines -----------------------------------------------------------*/
-// Define as 1 to draw the snake with 3 pixels width
-#define SNAKE_THINNER   0
-
-// Rectangle coordinates (in pixels)
-#define SNAKE_RECT_X1   0
-#define SNAKE_RECT_Y1   0
-#define SNAKE_RECT_X2   83
-#define SNAKE_RECT_Y2   47
-
-// Each snake part has 4 pixels
-#define SNAKE_PART_SIZE   4
-
-#define SNAKE_MAX_SIZE  220
-#define SNAKE_MAX_X     20
-#define SNAKE_MAX_Y     11
-
-#define SNAKE_INIT_FOOD_X   10
-#define SNAKE_INIT_FOOD_Y   5
-#define SNAKE_INIT_SIZE     3
-
-// Initial available pixels for the game
-#define SNAKE_X_0       2
-#define SNAKE_Y_0       2
+static uint8_t snake_place_food(snake_game_t* game) {
+    if (game->free_cell_nr == 0) {
+        return 0;
+    }
 
-#define SNAKE_DEBOUNCE_TIME_MS  10
+    PROFILE_START(PROFILE_PLACE_FOOD);
 
-#define SNAKE_KEYBOARD_PORT         GPIOB
-#define SNAKE_KEYBOARD_CLOCK_EN()   __HAL_RCC_GPIOB_CLK_ENABLE()
-#define SNAKE_KEYBOARD_RIGHT_PIN    GPIO_PIN_12
-#define SNAKE_KEYBOARD_DOWN_PIN     GPIO_PIN_13
-#define SNAKE_KEYBOARD_LEFT_PIN     GPIO_PIN_14
-#define SNAKE_KEYBOARD_UP_PIN       GPIO_PIN_15
+    snake_cell_t cell = game->free_cells[prng_below(&game->prng, game->free_cell_nr)];
 
-/* Private variables ---------------------------------------------------------*/
-// Snake and food coordinates
-static snake_pos_t snake[SNAKE_MAX_SIZE] = { 0 };
-static snake_pos_t food = { 0 };
-static snake_state_t game_state;
-static snake_dir_t direction;
-static snake_dir_t last_direction;
-static snake_key_t key_pressed;
-static uint8_t size = 0;
-static uint8_t head = 0;
+    game->food.x = SNAKE_CELL_X(cell);
+    game->food.y = SNAKE_CELL_Y(cell);
 
-/* Private function prototypes -----------------------------------------------*/
-static snake_collision_t snake_check_collision(snake_pos_t position);
-static void snake_draw_part(snake_pos_t part_coord);
-static void snake_erase_part(snake_pos_t part_coord);
-static void snake_draw_food(void);
-static void snake_kbd_debounce(void);
+    PROFILE_END(PROFILE_PLACE_FOOD);
+    return 1;
+}
 
-/* Private function implementation--------------------------------------------*/
 /**
  * @ingroup snake
  * @brief Checks if the given position is inside the snake.
  *
- * @param position  Coordinate to check.
+ * Covered cells are the ones past the free cells in the free cell
+ * index, so the cost doesn't depend on the snake size.
+ *
+ * @param game  Game.
+ * @param cell  Cell to check.
  *
  * @return TRUE, if the point is inside the snake, FALSE, otherwise.
  */
-static snake_collision_t snake_check_collision(snake_pos_t position) {
-    // Compare the given position with all snake parts
-    for (uint8_t i = 0; i < size; i++) {
-        uint8_t compare_pos = head + i;
-        if (compare_pos >= SNAKE_MAX_SIZE) {
-            compare_pos -= SNAKE_MAX_SIZE;
-        }
+static snake_collision_t snake_check_collision(const snake_game_t* game, snake_cell_t cell) {
+    PROFILE_START(PROFILE_CHECK_COLLISION);
 
-        if ((position.x == snake[compare_pos].x) &&
-            (position.y == snake[compare_pos].y)) {
-            return SNAKE_COLLISION_TRUE;
-        }
+    snake_collision_t collision = SNAKE_COLLISION_FALSE;
+
+    if (game->free_slot[cell] >= game->free_cell_nr) {
+        collision = SNAKE_COLLISION_TRUE;
     }
 
-    return SNAKE_COLLISION_FALSE;
+    PROFILE_END(PROFILE_CHECK_COLLISION);
+    return collision;
 }
 
 /**
  * @ingroup snake
  * @brief Draw the food
+ *
+ * @param game  Game.
  */
-static void snake_draw_food(void) {
-    uint8_t x = SNAKE_X_0 + SNAKE_PART_SIZE * food.x;
-    uint8_t y = SNAKE_Y_0 + SNAKE_PART_SIZE * food.y;
-
-    nokia5110_set_pixel(x + 1, y + 1);
-    nokia5110_set_pixel(x + 2, y + 2);
-    nokia5110_set_pixel(x + 1, y + 3);
-    nokia5110_set_pixel(x, y + 2);
+static void snake_draw_food(const snake_game_t* game) {
+    if (game->headless != 0) {
+        return;
+    }
+
+    uint8_t x = game->x0 + SNAKE_X_0 + SNAKE_PART_SIZE * game->food.x;
+    uint8_t y = game->y0 + SNAKE_Y_0 + SNAKE_PART_SIZE * game->food.y;
+
+    nokia5110_blit(food_glyph, x, y, SNAKE_FOOD_WIDTH, SNAKE_FOOD_HEIGHT, NOKIA5110_OP_OR);
 }
 
 /**
  * @ingroup snake
  * @brief Draw a snake part
  *
- * @param part_coord  Coordinates of the part to draw.
+ * @param game  Game.
+ * @param cell  Cell of the part to draw.
  */
-static void snake_draw_part(snake_pos_t part_coord) {
-    uint8_t x = SNAKE_X_0 + SNAKE_PART_SIZE * part_coord.x;
-    uint8_t y = SNAKE_Y_0 + SNAKE_PART_SIZE * part_coord.y;
-
-    for (uint8_t i = 0; i < SNAKE_PART_SIZE; i++) {
-        for (uint8_t j = 0; j < SNAKE_PART_SIZE; j++) {
-            nokia5110_set_pixel(x + i, y + j);
-        }
+static void snake_draw_part(const snake_game_t* game, snake_cell_t cell) {
+    if (game->headless != 0) {
+        return;
     }
+
+    PROFILE_START(PROFILE_DRAW_PART);
+
+    uint8_t line = SNAKE_CELL_Y(cell);
+
+    nokia5110_set_columns(SNAKE_ORIGIN_OFFSET(game) + snake_lut_offset[cell], SNAKE_PART_SIZE,
+                          snake_lut_mask[line][0], snake_lut_mask[line][1]);
 #if (SNAKE_THINNER == 1)
+    uint8_t x = game->x0 + SNAKE_X_0 + SNAKE_PART_SIZE * SNAKE_CELL_X(cell);
+    uint8_t y = game->y0 + SNAKE_Y_0 + SNAKE_PART_SIZE * line;
+
     // Personalizes the part according to directions
-    if (direction == SNAKE_DIR_RIGHT || direction == SNAKE_DIR_LEFT) {
+    if (game->direction == SNAKE_DIR_RIGHT || game->direction == SNAKE_DIR_LEFT) {
         // Horizontal
         for (uint8_t i = 0; i < SNAKE_PART_SIZE; i++) {
             nokia5110_clr_pixel(x + i, y);
@@ -191,307 +254,413 @@ static void snake_draw_part(snake_pos_t part_coord) {
             nokia5110_clr_pixel(x + SNAKE_PART_SIZE - 1, y + i);
         }
     }
-    if (last_direction != direction) {
+    if (game->last_direction != game->direction) {
         // Corner
-        uint8_t last_head = head + 1;
+        snake_cell_t last_head = game->snake[SNAKE_RING(game->head + 1)];
 
-        if (last_head == SNAKE_MAX_SIZE) {
-            last_head = 0;
-        }
+        uint8_t x = game->x0 + SNAKE_X_0 + SNAKE_PART_SIZE * SNAKE_CELL_X(last_head);
+        uint8_t y = game->y0 + SNAKE_Y_0 + SNAKE_PART_SIZE * SNAKE_CELL_Y(last_head);
 
-        uint8_t x = SNAKE_X_0 + SNAKE_PART_SIZE * snake[last_head].x;
-        uint8_t y = SNAKE_Y_0 + SNAKE_PART_SIZE * snake[last_head].y;
-
-        if (last_direction == SNAKE_DIR_UP && direction == SNAKE_DIR_RIGHT) {
+        if (game->last_direction == SNAKE_DIR_UP && game->direction == SNAKE_DIR_RIGHT) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_clr_pixel(x + i, y);
             }
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_set_pixel(x + SNAKE_PART_SIZE - 1, y + 1 + i);
             }
-        } else if (last_direction == SNAKE_DIR_UP && direction == SNAKE_DIR_LEFT) {
+        } else if (game->last_direction == SNAKE_DIR_UP && game->direction == SNAKE_DIR_LEFT) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_clr_pixel(x + i, y);
             }
-        } else if (last_direction == SNAKE_DIR_DOWN && direction == SNAKE_DIR_RIGHT) {
+        } else if (game->last_direction == SNAKE_DIR_DOWN && game->direction == SNAKE_DIR_RIGHT) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_set_pixel(x + SNAKE_PART_SIZE - 1, y + 1 + i);
             }
-        } else if (last_direction == SNAKE_DIR_RIGHT && direction == SNAKE_DIR_UP) {
+        } else if (game->last_direction == SNAKE_DIR_RIGHT && game->direction == SNAKE_DIR_UP) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_set_pixel(x + i, y);
             }
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_clr_pixel(x + SNAKE_PART_SIZE - 1, y + 1 + i);
             }
-        } else if (last_direction == SNAKE_DIR_RIGHT && direction == SNAKE_DIR_DOWN) {
+        } else if (game->last_direction == SNAKE_DIR_RIGHT && game->direction == SNAKE_DIR_DOWN) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_clr_pixel(x + SNAKE_PART_SIZE - 1, y + 1 + i);
             }
-        } else if (last_direction == SNAKE_DIR_LEFT && direction == SNAKE_DIR_UP) {
+        } else if (game->last_direction == SNAKE_DIR_LEFT && game->direction == SNAKE_DIR_UP) {
             for (uint8_t i = 0; i < SNAKE_PART_SIZE - 1; i++) {
                 nokia5110_set_pixel(x + i, y);
             }
         }
     }
 #endif /* SNAKE_THINNER */
+
+    PROFILE_END(PROFILE_DRAW_PART);
 }
 
 /**
  * @ingroup snake
  * @brief Erase a snake part
  *
- * @param part_coord  Coordinates of the part to erase.
+ * @param game  Game.
+ * @param cell  Cell of the part to erase.
  */
-static void snake_erase_part(snake_pos_t part_coord) {
-    uint8_t x = SNAKE_X_0 + SNAKE_PART_SIZE * part_coord.x;
-    uint8_t y = SNAKE_Y_0 + SNAKE_PART_SIZE * part_coord.y;
-
-    for (uint8_t i = 0; i < SNAKE_PART_SIZE; i++) {
-        for (uint8_t j = 0; j < SNAKE_PART_SIZE; j++) {
-            nokia5110_clr_pixel(x + i, y + j);
-        }
+static void snake_erase_part(const snake_game_t* game, snake_cell_t cell) {
+    if (game->headless != 0) {
+        return;
     }
+
+    uint8_t line = SNAKE_CELL_Y(cell);
+
+    nokia5110_clr_columns(SNAKE_ORIGIN_OFFSET(game) + snake_lut_offset[cell], SNAKE_PART_SIZE,
+                          snake_lut_mask[line][0], snake_lut_mask[line][1]);
 }
 
 /**
  * @ingroup snake
- * @brief Reads the keyboard and debounces the keys.
+ * @brief Gets the next cell in a direction, wrapping around the board
+ * edges.
+ *
+ * @param cell      Cell.
+ * @param direction Moving direction.
  *
- * Only updates the key_pressed varible after the keys' state
- * keeps stable for 10 cycles.
+ * @return Next cell index.
  */
-static void snake_kbd_debounce(void) {
-    static snake_key_t previous_key = SNAKE_KEY_NONE;
-    static uint32_t debounce_timeshot = 0;
+static snake_cell_t snake_next_cell(snake_cell_t cell, snake_dir_t direction) {
+    uint8_t x = SNAKE_CELL_X(cell);
 
-    snake_key_t current_key = SNAKE_KEY_NONE;
-    if (HAL_GPIO_ReadPin(SNAKE_KEYBOARD_PORT, SNAKE_KEYBOARD_RIGHT_PIN) == GPIO_PIN_RESET) {
-        current_key = SNAKE_KEY_RIGHT;
+    switch (direction) {
+        case SNAKE_DIR_RIGHT:
+            return (x == SNAKE_MAX_X - 1) ? cell - (SNAKE_MAX_X - 1) : cell + 1;
+        case SNAKE_DIR_DOWN:
+            return (cell >= SNAKE_CELLS - SNAKE_MAX_X) ? cell - (SNAKE_CELLS - SNAKE_MAX_X) : cell + SNAKE_MAX_X;
+        case SNAKE_DIR_LEFT:
+            return (x == 0) ? cell + (SNAKE_MAX_X - 1) : cell - 1;
+        case SNAKE_DIR_UP:
+        default:
+            return (cell < SNAKE_MAX_X) ? cell + (SNAKE_CELLS - SNAKE_MAX_X) : cell - SNAKE_MAX_X;
     }
-    if (HAL_GPIO_ReadPin(SNAKE_KEYBOARD_PORT, SNAKE_KEYBOARD_DOWN_PIN) == GPIO_PIN_RESET) {
-        current_key = SNAKE_KEY_DOWN;
+}
+
+/**
+ * @ingroup snake
+ * @brief Draws the borders, the snake and the food on a clear board.
+ *
+ * Only the board area is cleared, the rest of the display is kept.
+ *
+ * @param game  Game.
+ */
+static void snake_draw_board(snake_game_t* game) {
+    if (game->headless != 0) {
+        return;
     }
-    if (HAL_GPIO_ReadPin(SNAKE_KEYBOARD_PORT, SNAKE_KEYBOARD_LEFT_PIN) == GPIO_PIN_RESET) {
-        current_key = SNAKE_KEY_LEFT;
+
+    nokia5110_erase_rect(game->x0, game->y0, SNAKE_BOARD_WIDTH, SNAKE_BOARD_HEIGHT);
+    nokia5110_draw_rectangle(game->x0, game->y0,
+                             game->x0 + SNAKE_BOARD_WIDTH - 1, game->y0 + SNAKE_BOARD_HEIGHT - 1);
+
+    for (snake_cell_t i = 0; i < game->size; i++) {
+        snake_draw_part(game, game->snake[i]);
     }
-    if (HAL_GPIO_ReadPin(SNAKE_KEYBOARD_PORT, SNAKE_KEYBOARD_UP_PIN) == GPIO_PIN_RESET) {
-        current_key = SNAKE_KEY_UP;
+    snake_draw_food(game);
+
+    snake_present(game, 1);
+}
+
+/**
+ * @ingroup snake
+ * @brief Shows the game over or win message.
+ *
+ * @param game  Game.
+ */
+static void snake_draw_end(snake_game_t* game) {
+    if (game->headless != 0) {
+        return;
     }
 
-    if (previous_key != current_key) {
-        previous_key = current_key;
-        debounce_timeshot = HAL_GetTick();
+    uint8_t x = game->x0 + SNAKE_TEXT_X;
+    uint8_t line = game->y0 / 8 + SNAKE_TEXT_LINE;
 
-    } else if (HAL_GetTick() - debounce_timeshot >= SNAKE_DEBOUNCE_TIME_MS) {
-        /** Same key pressed for 10 ms, update the key pressed only if it's
-         *  different than none, to let the update function clear the key pressed.
-         */
-        if (current_key != SNAKE_KEY_NONE) {
-            key_pressed = current_key;
-        }
+    if (game->state == SNAKE_STATE_WIN) {
+        nokia5110_string_at("  You Win!  ", x, line);
+    } else {
+        nokia5110_string_at(" Game Over! ", x, line);
+        nokia5110_string_at(" Score:     ", x, line + 1);
+        nokia5110_char_at('0' + (game->size / 100), game->x0 + SNAKE_SCORE_X, line + 1);
+        nokia5110_char('0' + ((game->size / 10) % 10));
+        nokia5110_char('0' + (game->size % 10));
     }
+    snake_present(game, 0);
 }
 
-/* Public functions ----------------------------------------------------------*/
 /**
  * @ingroup snake
- * @brief Inits the snake game
- *
- * Sets up the keyboard, resets the game parameters and draw 
- * the initial food and snake.
+ * @brief Sends the drawn frame, or hands it to the game present hook.
  *
- * The available pixels for the game are within th following range:
- * x = (2, 81) and y = (2, 45).
+ * @param game      Game.
+ * @param blocking  1 to wait for the whole screen to be sent, 0 to let
+ *                  the changes go by DMA (no effect with a hook).
+ */
+static void snake_present(snake_game_t* game, uint8_t blocking) {
+    if (game->present != NULL) {
+        game->present(game);
+    } else if (blocking != 0) {
+        nokia5110_update_screen();
+    } else {
+        nokia5110_present();
+    }
+}
+
+/**
+ * @ingroup snake
+ * @brief Default game input, reads the keyboard queue.
  *
- * Each snake part has 4 pixels, so dividing it, the game has 20
- * horizontal and 11 vertical spaces available.
+ * @param game  Game, unused.
+ * @param key   Output key, NULL to drop the queued keys.
  *
- * @note The function @ref nokia5110_update_screen must be called
- * to actually update the screen.
+ * @return 1 if a key was read, 0 otherwise.
  */
-void snake_init(void) {
-    GPIO_InitTypeDef gpio_init = { 0 };
+static uint8_t snake_keyboard_input(snake_game_t* game, keyboard_key_t* key) {
+    keyboard_event_t event;
 
-    SNAKE_KEYBOARD_CLOCK_EN();
+    (void)game;
+    if (key == NULL) {
+        keyboard_clear();
+        return 0;
+    }
 
-    // PB12 = Right | PB13 = Down | PB14 = Left | PB15 = Up
-    gpio_init.Pin = SNAKE_KEYBOARD_RIGHT_PIN | SNAKE_KEYBOARD_DOWN_PIN | SNAKE_KEYBOARD_LEFT_PIN | SNAKE_KEYBOARD_UP_PIN;
-    gpio_init.Mode = GPIO_MODE_INPUT;
-    gpio_init.Pull = GPIO_PULLUP;
-    gpio_init.Speed = GPIO_SPEED_FREQ_HIGH;
-    HAL_GPIO_Init(SNAKE_KEYBOARD_PORT, &gpio_init);
+    if (keyboard_read(&event) == 0) {
+        return 0;
+    }
 
-    nokia5110_setup();
+    *key = event.key;
+    return 1;
+}
 
-    // Draw game borders
-    nokia5110_clear_buffer();
-    nokia5110_draw_rectangle(SNAKE_RECT_X1, SNAKE_RECT_Y1, SNAKE_RECT_X2, SNAKE_RECT_Y2);
-    
-    // Initial position
-    snake[0].x = 2;
-    snake[0].y = 0;
+/**
+ * @ingroup snake
+ * @brief Takes the next queued key press that turns the snake.
+ *
+ * Presses of the current direction or of its opposite don't turn the
+ * snake, so they are skipped instead of wasting a step.
+ *
+ * @param game  Game.
+ * @param input Key source.
+ *
+ * @return New direction, or the current one if no turn is queued.
+ */
+static snake_dir_t snake_next_direction(snake_game_t* game, snake_input_t input) {
+    keyboard_key_t key;
+
+    while (input(game, &key) != 0) {
+        snake_dir_t turn = game->direction;
+
+        switch (key) {
+            case KEYBOARD_KEY_RIGHT:
+                if (game->direction != SNAKE_DIR_LEFT) {
+                    turn = SNAKE_DIR_RIGHT;
+                }
+            break;
+            case KEYBOARD_KEY_DOWN:
+                if (game->direction != SNAKE_DIR_UP) {
+                    turn = SNAKE_DIR_DOWN;
+                }
+            break;
+            case KEYBOARD_KEY_LEFT:
+                if (game->direction != SNAKE_DIR_RIGHT) {
+                    turn = SNAKE_DIR_LEFT;
+                }
+            break;
+            case KEYBOARD_KEY_UP:
+                if (game->direction != SNAKE_DIR_DOWN) {
+                    turn = SNAKE_DIR_UP;
+                }
+            break;
+            default:
+            break;
+        }
 
-    snake[1].x = 1;
-    snake[1].y = 0;
+        if (turn != game->direction) {
+            return turn;
+        }
+    }
 
-    snake[2].x = 0;
-    snake[2].y = 0;
+    return game->direction;
+}
 
-    food.x = SNAKE_INIT_FOOD_X;
-    food.y = SNAKE_INIT_FOOD_Y;
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup snake
+ * @brief Seeds the food placement.
+ *
+ * Also restarts the step count given to the game input. From there,
+ * the games only depend on the seed and on the keys read at each step.
+ * The generator isn't reset by @ref snake_init, so each new game gets
+ * other food positions.
+ *
+ * @param game  Game.
+ * @param seed  Generator seed.
+ */
+void snake_seed(snake_game_t* game, uint32_t seed) {
+    prng_seed(&game->prng, seed);
+    game->step = 0;
+}
 
-    game_state = SNAKE_STATE_PLAYING;
-    direction = SNAKE_DIR_RIGHT;
-    key_pressed = SNAKE_KEY_NONE;
-    size = SNAKE_INIT_SIZE;
-    head = 0;
+/**
+ * @ingroup snake
+ * @brief Starts a new game.
+ *
+ * Resets the snake and the food and, unless headless, draws the board
+ * at the game origin. The display must be set up before (see
+ * @ref nokia5110_setup).
+ *
+ * The board has SNAKE_MAX_X horizontal and SNAKE_MAX_Y vertical cells
+ * of SNAKE_PART_SIZE pixels, by default 20 x 11 cells of 4 pixels,
+ * 84 x 48 pixels with the borders.
+ *
+ * @param game  Game, seeded with SNAKE_DEFAULT_SEED if it wasn't
+ * (see @ref snake_seed).
+ */
+void snake_init(snake_game_t* game) {
+    if (game->prng.state == 0) {
+        snake_seed(game, SNAKE_DEFAULT_SEED);
+    }
+
+    // Initial position
+    game->snake[0] = SNAKE_CELL(2, 0);
+    game->snake[1] = SNAKE_CELL(1, 0);
+    game->snake[2] = SNAKE_CELL(0, 0);
+
+    game->food.x = SNAKE_INIT_FOOD_X;
+    game->food.y = SNAKE_INIT_FOOD_Y;
+
+    game->state = SNAKE_STATE_PLAYING;
+    game->direction = SNAKE_DIR_RIGHT;
+    game->last_direction = SNAKE_DIR_RIGHT;
+    game->size = SNAKE_INIT_SIZE;
+    game->head = 0;
+
+    for (snake_cell_t i = 0; i < SNAKE_CELLS; i++) {
+        game->free_cells[i] = i;
+        game->free_slot[i] = i;
+    }
+    game->free_cell_nr = SNAKE_CELLS;
 
-    // Draw init snake and food
-    for (uint8_t i = 0; i < size; i++) {
-        snake_draw_part(snake[i]);
+    for (snake_cell_t i = 0; i < game->size; i++) {
+        snake_occupy(game, game->snake[i]);
     }
-    snake_draw_food();
 
-    nokia5110_update_screen();
+    snake_draw_board(game);
 }
 
 /**
  * @ingroup snake
- * @brief Updates the snake game
+ * @brief Runs a game step
  *
- * Recalculates the direction based on the key pressed and moves the
- * snake head according to it.
+ * Recalculates the direction based on the next queued key press and
+ * moves the snake head according to it.
  * Checks if the new head is inside the snake itself, changing the
  * game state to game over, and if it's equal the food coordinates,
  * increasing snake size and drawing the next food.
  *
- * @note The function @ref nokia5110_update_screen must be called
- * to actually update the screen.
+ * On the game over and win screens, any key starts a new game. The
+ * input drops its queued keys when a game ends or starts (see
+ * @ref snake_input_t).
+ *
+ * Unless headless, the screen update is started at the end and runs
+ * by DMA while the next step is computed, or handed to the present hook
+ * of the game. The caller sets the pace (see
+ * @ref scheduler_step_due).
+ *
+ * @param game  Game, started before (see @ref snake_init).
+ * @param input Key source, see @ref snake_input_t.
  */
-void snake_update(void) {
-    static uint32_t update_timeshot = 0;
+void snake_step(snake_game_t* game, snake_input_t input) {
+    if (input == NULL) {
+        input = snake_keyboard_input;
+    }
 
-    snake_kbd_debounce();
+    PROFILE_START(PROFILE_SNAKE_STEP);
+    game->step++;
 
-    if (HAL_GetTick() - update_timeshot >= 100) {
-        update_timeshot = HAL_GetTick();
-    } else {
-        return;
-    }
+    // If game over or won, waits for input to reset
+    if (game->state != SNAKE_STATE_PLAYING) {
+        keyboard_key_t key;
 
-    // If game over, waits for input to reset
-    if (game_state == SNAKE_STATE_GAME_OVER) {
-        if (key_pressed != SNAKE_KEY_NONE) {
-            snake_init();
+        if (input(game, &key) != 0) {
+            snake_init(game);
+            input(game, NULL);
         }
+        PROFILE_END(PROFILE_SNAKE_STEP);
         return;
     }
 
-    uint16_t tail = head + size - 1;
-    uint8_t new_head = head - 1;
+    // The ring size is a power of two, the positions wrap with a mask
+    snake_index_t tail = SNAKE_RING(game->head + game->size - 1);
+    snake_index_t new_head = SNAKE_RING(game->head - 1);
 
-    if (head == 0) {
-        // Last array position (circular buffer)
-        new_head = SNAKE_MAX_SIZE - 1;
-    }
-
-    if (tail >= SNAKE_MAX_SIZE) {
-        tail -= SNAKE_MAX_SIZE;
-    }
-
-    last_direction = direction;
-
-    // Updates direction
-    switch (key_pressed) {
-        case SNAKE_KEY_RIGHT:
-            if (direction != SNAKE_DIR_LEFT) {
-                direction = SNAKE_DIR_RIGHT;
-            }
-        break;
-        case SNAKE_KEY_DOWN:
-            if (direction != SNAKE_DIR_UP) {
-                direction = SNAKE_DIR_DOWN;
-            }
-        break;
-        case SNAKE_KEY_LEFT:
-            if (direction != SNAKE_DIR_RIGHT) {
-                direction = SNAKE_DIR_LEFT;
-            }
-        break;
-        case SNAKE_KEY_UP:
-            if (direction != SNAKE_DIR_DOWN) {
-                direction = SNAKE_DIR_UP;
-            }
-        break;
-        default:
-        // Keep direction
-        break;
-    }
+    // Takes one queued turn per step
+    game->last_direction = game->direction;
+    game->direction = snake_next_direction(game, input);
 
     // Calculates the new head
-    switch (direction) {
-        case SNAKE_DIR_RIGHT:
-            snake[new_head].y = snake[head].y;
-            snake[new_head].x = snake[head].x + 1;
-            if (snake[new_head].x == SNAKE_MAX_X) {
-                snake[new_head].x = 0;
-            }
-        break;
-        case SNAKE_DIR_DOWN:
-            snake[new_head].x = snake[head].x;
-            snake[new_head].y = snake[head].y + 1;
-            if (snake[new_head].y == SNAKE_MAX_Y) {
-                snake[new_head].y = 0;
-            }
-        break;
-        case SNAKE_DIR_LEFT:
-            snake[new_head].y = snake[head].y;
-            snake[new_head].x = snake[head].x - 1;
-            if (snake[head].x == 0) {
-                snake[new_head].x = SNAKE_MAX_X - 1;
-            }
-        break;
-        case SNAKE_DIR_UP:
-            snake[new_head].x = snake[head].x;
-            snake[new_head].y = snake[head].y - 1;
-            if (snake[head].y == 0) {
-                snake[new_head].y = SNAKE_MAX_Y - 1;
-            }
-        break;
-    }
-    
+    game->snake[new_head] = snake_next_cell(game->snake[game->head], game->direction);
+
     // Checks collision
-    if (snake_check_collision(snake[new_head]) == SNAKE_COLLISION_TRUE) {
+    if (snake_check_collision(game, game->snake[new_head]) == SNAKE_COLLISION_TRUE) {
         // New head hitted a snake part
-        nokia5110_string_at(" Game Over! ", 6, 2);
-        nokia5110_string_at(" Score:     ", 6, 3);
-        nokia5110_char_at('0' + (size / 100), 52, 3);
-        nokia5110_char('0' + ((size / 10) % 10));
-        nokia5110_char('0' + (size % 10));
-        game_state = SNAKE_STATE_GAME_OVER;
-        key_pressed = SNAKE_KEY_NONE;
+        game->state = SNAKE_STATE_GAME_OVER;
+        snake_draw_end(game);
+        input(game, NULL);
+        PROFILE_END(PROFILE_SNAKE_STEP);
         return;
     }
 
     // Prints new head
-    head = new_head;
-    snake_draw_part(snake[head]);
+    game->head = new_head;
+    snake_occupy(game, game->snake[game->head]);
+    snake_draw_part(game, game->snake[game->head]);
 
     // Checks if new head reached the food
-    if ((snake[new_head].x == food.x) &&
-        (snake[new_head].y == food.y)) {
-        size++;
-        // Calculates new food position
-        do {
-            food.x = rand() % SNAKE_MAX_X;
-            food.y = rand() % SNAKE_MAX_Y;
-        } while (snake_check_collision(food) == SNAKE_COLLISION_TRUE);
-        snake_draw_food();
+    if (game->snake[new_head] == SNAKE_CELL(game->food.x, game->food.y)) {
+        game->size++;
+        // Calculates new food position, no free cell left means a win
+        if (snake_place_food(game) == 0) {
+            game->state = SNAKE_STATE_WIN;
+            snake_draw_end(game);
+            input(game, NULL);
+            PROFILE_END(PROFILE_SNAKE_STEP);
+            return;
+        }
+        snake_draw_food(game);
     } else {
         // Erases tail only if didn't reached the food
-        snake_erase_part(snake[tail]);
+        snake_vacate(game, game->snake[tail]);
+        snake_erase_part(game, game->snake[tail]);
+    }
+
+    if (game->headless == 0) {
+        PROFILE_START(PROFILE_SCREEN_UPDATE);
+        snake_present(game, 0);
+        PROFILE_END(PROFILE_SCREEN_UPDATE);
     }
 
-    nokia5110_update_screen();
+    PROFILE_END(PROFILE_SNAKE_STEP);
+}
+
+/**
+ * @ingroup snake
+ * @brief Checks if the game is waiting for a key on the game over or
+ * win screen.
+ *
+ * Nothing changes on the screen until its input gives a key, so once
+ * the input is idle too (e.g. @ref keyboard_is_idle for the keyboard)
+ * the MCU may stop meanwhile.
+ *
+ * @param game  Game.
+ *
+ * @return 1 if idle, 0 otherwise.
+ */
+uint8_t snake_is_idle(const snake_game_t* game) {
+    return (game->state != SNAKE_STATE_PLAYING);
 }
@@ -5,6 +5,11 @@
 
 #include "stm32f1xx_hal.h"
 
+#include "nokia5110.h"
+#include "scheduler.h"
+#include "keyboard.h"
+#include "rtos.h"
+
 /******************************************************************************/
 /*           Cortex-M3 Processor Interruption and Exception Handlers         */
 /******************************************************************************/
@@ -43,11 +48,15 @@ void UsageFault_Handler(void) {
     while (1);
 }
 
+#if (RTOS_ENABLED == 0)
 /**
  * @brief This function handles System service call via SWI instruction.
+ *
+ * The RTOS build takes it from the FreeRTOS port (see FreeRTOSConfig.h).
  */
 void SVC_Handler(void) {
 }
+#endif
 
 /**
  * @brief This function handles Debug monitor.
@@ -55,15 +64,46 @@ void SVC_Handler(void) {
 void DebugMon_Handler(void) {
 }
 
+#if (RTOS_ENABLED == 0)
 /**
  * @brief This function handles Pendable request for system service.
+ *
+ * The RTOS build takes it from the FreeRTOS port (see FreeRTOSConfig.h).
  */
 void PendSV_Handler(void) {
 }
+#endif
 
 /**
  * @brief SysTick timer.
  */
 void SysTick_Handler(void) {
     HAL_IncTick();
+#if (RTOS_ENABLED == 1)
+    rtos_tick_handler();
+#endif
+}
+
+/******************************************************************************/
+/*                      STM32F1xx Peripheral Interrupt Handlers               */
+/******************************************************************************/
+/**
+ * @brief DMA1 channel 3 (SPI1 TX, display).
+ */
+void DMA1_Channel3_IRQHandler(void) {
+    nokia5110_dma_irq_handler();
+}
+
+/**
+ * @brief TIM2 global interrupt (game tick scheduler).
+ */
+void TIM2_IRQHandler(void) {
+    scheduler_irq_handler();
+}
+
+/**
+ * @brief EXTI lines 10 to 15 (keys).
+ */
+void EXTI15_10_IRQHandler(void) {
+    keyboard_irq_handler();
 }
@@ -11,7 +11,36 @@
 
 #include "stm32f1xx_hal.h"
 
+#include <string.h>
+
 /* Private types -------------------------------------------------------------*/
+/**
+ * @ingroup nokia5110
+ * @brief Contiguous range of the screen_buffer queued to be sent.
+ */
+typedef struct {
+    uint16_t start;     /**< First screen_buffer index. */
+    uint16_t length;    /**< Number of bytes. */
+} nokia5110_span_t;
+
+/**
+ * @ingroup nokia5110
+ * @brief Bytes sent with the same DC level.
+ */
+typedef struct {
+    const uint8_t* bytes;   /**< First byte. */
+    uint16_t length;        /**< Number of bytes. */
+    uint8_t dc;             /**< DC level: 0 for commands, 1 for data. */
+} nokia5110_segment_t;
+
+/**
+ * @ingroup nokia5110
+ * @brief Display transfer state.
+ */
+typedef enum {
+    NOKIA5110_FLUSH_IDLE = 0,   /**< No transfer in progress. */
+    NOKIA5110_FLUSH_BUSY,       /**< Sending the queue segments by DMA. */
+} nokia5110_flush_phase_t;
 
 /* Private defines -----------------------------------------------------------*/
 #define NOKIA5110_COL_PER_CHAR  5
@@ -27,9 +56,33 @@
 #define NOKIA5110_MISO_PIN          GPIO_PIN_6
 #define NOKIA5110_MOSI_PIN          GPIO_PIN_7
 
+// SPI1_TX request is mapped to DMA1 channel 3
+#define NOKIA5110_DMA_INSTANCE      DMA1_Channel3
+#define NOKIA5110_DMA_CLOCK_EN()    __HAL_RCC_DMA1_CLK_ENABLE()
+#define NOKIA5110_DMA_IRQ           DMA1_Channel3_IRQn
+#define NOKIA5110_DMA_IRQ_PRIORITY  1
+
 #define NOKIA5110_SPI_TIMEOUT       50
+
+/** Sends the screen updates by DMA (1) or with blocking transfers (0). */
+#ifndef NOKIA5110_USE_DMA
+#define NOKIA5110_USE_DMA           1
+#endif
 #define NOKIA5110_RESET_PULSE_MS    10
 
+/** Fastest SPI clock of the display (PCD8544: 4 Mbit/s). */
+#ifndef NOKIA5110_SPI_MAX_HZ
+#define NOKIA5110_SPI_MAX_HZ        4000000
+#endif
+
+/**
+ * Define as 1 when MISO is wired to MOSI: @ref nokia5110_setup then runs
+ * @ref nokia5110_link_test, reading the test patterns back.
+ */
+#ifndef NOKIA5110_LINK_LOOPBACK
+#define NOKIA5110_LINK_LOOPBACK     0
+#endif
+
 /** Function set */
 #define NOKIA5110_CMD_FUNC_SET              0x20
 #define NOKIA5110_CMD_POWER_EN              0x00
@@ -52,10 +105,38 @@
 #define NOKIA5110_CMD_DEFAULT_CONTRAST      0x10
 
 #define NOKIA5110_FIRST_CHAR_VALUE          0x20
+#define NOKIA5110_CHARS_NR                  (sizeof(characters) / sizeof(characters[0]))
+
+// One dirty bit per screen_buffer byte, packed in 32 bits words
+#define NOKIA5110_DIRTY_WORDS       ((NOKIA5110_BYTES_NR + 31) / 32)
+/** Clean bytes merged into a span instead of sending new X/Y addresses (2 bytes). */
+#define NOKIA5110_DIRTY_GAP_MAX     2
+/** Spans per screen update. Further dirty bytes are merged into the last span. */
+#define NOKIA5110_MAX_SPANS         16
+/** Queue segments: an address and a data segment per span. */
+#define NOKIA5110_MAX_SEGMENTS      (2 * NOKIA5110_MAX_SPANS)
+/** Queued command bytes: an address per span. */
+#define NOKIA5110_MAX_CMD_BYTES     (2 * NOKIA5110_MAX_SPANS)
 
 /* Private variables ---------------------------------------------------------*/
 static SPI_HandleTypeDef spi_handle = { 0 };
-static uint16_t display_pos = 0;
+
+// SPI clock prescalers, the divider of index i is (2 << i)
+static const uint32_t link_prescalers[NOKIA5110_LINK_DIVIDERS_NR] = {
+    SPI_BAUDRATEPRESCALER_2, SPI_BAUDRATEPRESCALER_4, SPI_BAUDRATEPRESCALER_8, SPI_BAUDRATEPRESCALER_16,
+    SPI_BAUDRATEPRESCALER_32, SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_256,
+};
+static uint8_t link_divider_idx = NOKIA5110_LINK_DIVIDERS_NR - 1;
+
+// Link test patterns: steady levels, alternate bits and single edges
+static const uint8_t link_patterns[] = {
+    0x00, 0xFF, 0x55, 0xAA, 0x33, 0xCC, 0x0F, 0xF0,
+    0x01, 0x80, 0xFE, 0x7F, 0x00, 0xFF, 0xA5, 0x5A,
+};
+static DMA_HandleTypeDef dma_handle = { 0 };
+static uint8_t text_x = 0;
+static uint8_t text_line = 0;
+static nokia5110_stats_t frame_stats = { 0 };
 
 // ASCII characters array mapped to display pixels
 static const uint8_t characters[][NOKIA5110_COL_PER_CHAR] = {
@@ -193,9 +274,538 @@ static uint8_t screen_buffer[NOKIA5110_BYTES_NR] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
 };
 
+// Second frame buffer. Drawing goes to the back buffer while the front one is sent
+static uint8_t screen_buffer_b[NOKIA5110_BYTES_NR] = { 0 };
+static uint8_t* back_buffer = screen_buffer;
+static uint8_t* front_buffer = screen_buffer_b;
+
+// Back buffer bytes changed since the last screen update
+static uint32_t dirty_map[NOKIA5110_DIRTY_WORDS] = { 0 };
+
+// Spans of the last screen update
+static nokia5110_span_t flush_spans[NOKIA5110_MAX_SPANS] = { 0 };
+static uint8_t flush_span_nr = 0;
+
+// Command/data queue, sent in a single CS asserted burst
+static nokia5110_segment_t queue_segments[NOKIA5110_MAX_SEGMENTS] = { 0 };
+static uint8_t queue_segment_nr = 0;
+static uint8_t queue_segment_idx = 0;
+static uint8_t queue_cmds[NOKIA5110_MAX_CMD_BYTES] = { 0 };
+static uint8_t queue_cmd_nr = 0;
+static volatile nokia5110_flush_phase_t flush_phase = NOKIA5110_FLUSH_IDLE;
+
 /* Private function prototypes -----------------------------------------------*/
+static void nokia5110_mark_dirty(uint16_t buffer_pos);
+static void nokia5110_mark_dirty_span(uint16_t start, uint8_t length);
+static void nokia5110_mark_all_dirty(void);
+static uint8_t nokia5110_is_dirty(uint16_t buffer_pos);
+static void nokia5110_queue_span(uint16_t start, uint16_t end);
+static void nokia5110_queue_reset(void);
+static void nokia5110_queue_cmd(uint8_t cmd);
+static void nokia5110_queue_data(const uint8_t* data, uint16_t length);
+static void nokia5110_queue_addr(uint16_t buffer_pos);
+static void nokia5110_queue_blank_frame(void);
+static void nokia5110_queue_send_segment(void);
+static void nokia5110_queue_drain_sync(void);
+static void nokia5110_queue_drain_dma(void);
+static void nokia5110_wait_idle(void);
+static uint8_t nokia5110_link_fastest(void);
+static void nokia5110_link_apply(uint8_t divider_idx);
+static uint8_t nokia5110_link_check(void);
+static inline void nokia5110_write_byte(uint8_t* dest, uint8_t bits, uint8_t mask, nokia5110_op_t op);
+static inline void nokia5110_write_columns(uint8_t* column, uint8_t width, uint8_t mask, nokia5110_op_t op);
+static void nokia5110_raster(const uint8_t* bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height, nokia5110_op_t op);
 
 /* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup nokia5110
+ * @brief Flags a screen_buffer byte to be sent on the next screen update.
+ *
+ * @param buffer_pos    screen_buffer index (from 0 to 503).
+ */
+static void nokia5110_mark_dirty(uint16_t buffer_pos) {
+    dirty_map[buffer_pos / 32] |= (1UL << (buffer_pos % 32));
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Flags contiguous screen_buffer bytes to be sent on the next screen update.
+ *
+ * @param start     First screen_buffer index.
+ * @param length    Number of bytes.
+ */
+static void nokia5110_mark_dirty_span(uint16_t start, uint8_t length) {
+    uint16_t end = start + length;
+
+    while (start < end) {
+        uint8_t bit = start % 32;
+        uint8_t bits = 32 - bit;
+
+        if (bits > end - start) {
+            bits = end - start;
+        }
+
+        dirty_map[start / 32] |= (0xFFFFFFFFUL >> (32 - bits)) << bit;
+        start += bits;
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Flags the whole screen_buffer to be sent on the next screen update.
+ */
+static void nokia5110_mark_all_dirty(void) {
+    for (uint8_t i = 0; i < NOKIA5110_DIRTY_WORDS; i++) {
+        dirty_map[i] = 0xFFFFFFFF;
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Checks if a screen_buffer byte changed since the last update.
+ *
+ * @param buffer_pos    screen_buffer index (from 0 to 503).
+ *
+ * @return 1 if the byte must be sent, 0 otherwise.
+ */
+static uint8_t nokia5110_is_dirty(uint16_t buffer_pos) {
+    return (dirty_map[buffer_pos / 32] >> (buffer_pos % 32)) & 1;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Adds a contiguous span of the screen_buffer to the screen update.
+ *
+ * In horizontal addressing mode the display address wraps to the
+ * next line after the last column, the same way the screen_buffer
+ * is laid out, so a span may cross lines. That also allows merging
+ * the span into the previous one when the span list is full.
+ *
+ * @param start     First screen_buffer index of the span.
+ * @param end       screen_buffer index after the last byte of the span.
+ */
+static void nokia5110_queue_span(uint16_t start, uint16_t end) {
+    if (flush_span_nr == NOKIA5110_MAX_SPANS) {
+        nokia5110_span_t* last = &flush_spans[flush_span_nr - 1];
+
+        last->length = end - last->start;
+        return;
+    }
+
+    flush_spans[flush_span_nr].start = start;
+    flush_spans[flush_span_nr].length = end - start;
+    flush_span_nr++;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Empties the command/data queue and resets the transfer statistics.
+ *
+ * Must not be called while the queue is being sent.
+ */
+static void nokia5110_queue_reset(void) {
+    queue_segment_nr = 0;
+    queue_segment_idx = 0;
+    queue_cmd_nr = 0;
+
+    frame_stats.data_bytes = 0;
+    frame_stats.cmd_bytes = 0;
+    frame_stats.spans = 0;
+    frame_stats.segments = 0;
+    frame_stats.bursts = 0;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Adds a command byte to the queue.
+ *
+ * Command bytes are stored one after the other, so consecutive commands
+ * are merged into the same segment.
+ *
+ * @param cmd   Command byte.
+ */
+static void nokia5110_queue_cmd(uint8_t cmd) {
+    if (queue_cmd_nr == NOKIA5110_MAX_CMD_BYTES) {
+        return;
+    }
+
+    nokia5110_segment_t* last = (queue_segment_nr > 0) ? &queue_segments[queue_segment_nr - 1] : NULL;
+
+    queue_cmds[queue_cmd_nr] = cmd;
+
+    if (last != NULL && last->dc == 0 && last->bytes + last->length == &queue_cmds[queue_cmd_nr]) {
+        last->length++;
+    } else if (queue_segment_nr < NOKIA5110_MAX_SEGMENTS) {
+        queue_segments[queue_segment_nr].bytes = &queue_cmds[queue_cmd_nr];
+        queue_segments[queue_segment_nr].length = 1;
+        queue_segments[queue_segment_nr].dc = 0;
+        queue_segment_nr++;
+    } else {
+        return;
+    }
+
+    queue_cmd_nr++;
+    frame_stats.cmd_bytes++;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Adds data bytes to the queue.
+ *
+ * The bytes aren't copied and must stay unchanged until the queue is
+ * sent. Data contiguous to the last data segment is merged into it.
+ *
+ * @param data      First byte.
+ * @param length    Number of bytes.
+ */
+static void nokia5110_queue_data(const uint8_t* data, uint16_t length) {
+    nokia5110_segment_t* last = (queue_segment_nr > 0) ? &queue_segments[queue_segment_nr - 1] : NULL;
+
+    if (last != NULL && last->dc == 1 && last->bytes + last->length == data) {
+        last->length += length;
+    } else if (queue_segment_nr < NOKIA5110_MAX_SEGMENTS) {
+        queue_segments[queue_segment_nr].bytes = data;
+        queue_segments[queue_segment_nr].length = length;
+        queue_segments[queue_segment_nr].dc = 1;
+        queue_segment_nr++;
+    } else {
+        return;
+    }
+
+    frame_stats.data_bytes += length;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Adds the X/Y address commands of a screen_buffer index to the queue.
+ *
+ * @param buffer_pos    screen_buffer index (from 0 to 503).
+ */
+static void nokia5110_queue_addr(uint16_t buffer_pos) {
+    nokia5110_queue_cmd(NOKIA5110_CMD_Y_ADDR | (buffer_pos / NOKIA5110_MAX_COL_NR)); // Line
+    nokia5110_queue_cmd(NOKIA5110_CMD_X_ADDR | (buffer_pos % NOKIA5110_MAX_COL_NR)); // Column
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Adds a blank frame to the queue.
+ *
+ * The blank frame is sent from the front buffer, which may be cleared
+ * since the whole screen_buffer is flagged to be sent (and copied to the
+ * other buffer) on the next update anyway.
+ *
+ * Must not be called while a screen update is in progress.
+ */
+static void nokia5110_queue_blank_frame(void) {
+    nokia5110_mark_all_dirty();
+
+    for (uint16_t i = 0; i < NOKIA5110_BYTES_NR; i++) {
+        front_buffer[i] = 0;
+    }
+
+    nokia5110_queue_addr(0);
+    nokia5110_queue_data(front_buffer, NOKIA5110_BYTES_NR);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Starts the DMA transfer of the current queue segment.
+ *
+ * DC is only written when the segment level differs from the previous one.
+ */
+static void nokia5110_queue_send_segment(void) {
+    nokia5110_segment_t* segment = &queue_segments[queue_segment_idx];
+
+    if (queue_segment_idx == 0 || queue_segments[queue_segment_idx - 1].dc != segment->dc) {
+        HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, (segment->dc != 0) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+
+    HAL_SPI_Transmit_DMA(&spi_handle, (uint8_t*)segment->bytes, segment->length);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sends the queue in a single CS asserted burst and waits for it.
+ */
+static void nokia5110_queue_drain_sync(void) {
+    nokia5110_wait_idle();
+
+    frame_stats.segments = queue_segment_nr;
+    if (queue_segment_nr == 0) {
+        return;
+    }
+    frame_stats.bursts = 1;
+
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
+    for (uint8_t i = 0; i < queue_segment_nr; i++) {
+        nokia5110_segment_t* segment = &queue_segments[i];
+
+        if (i == 0 || queue_segments[i - 1].dc != segment->dc) {
+            HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, (segment->dc != 0) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+        }
+
+        HAL_SPI_Transmit(&spi_handle, (uint8_t*)segment->bytes, segment->length, NOKIA5110_SPI_TIMEOUT);
+    }
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Starts sending the queue in a single CS asserted burst by DMA.
+ *
+ * The following segments are sent from @ref HAL_SPI_TxCpltCallback, which
+ * calls @ref nokia5110_update_cplt_callback after the last one.
+ */
+static void nokia5110_queue_drain_dma(void) {
+    frame_stats.segments = queue_segment_nr;
+    if (queue_segment_nr == 0) {
+        nokia5110_update_cplt_callback();
+        return;
+    }
+    frame_stats.bursts = 1;
+
+    queue_segment_idx = 0;
+    flush_phase = NOKIA5110_FLUSH_BUSY;
+
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
+    nokia5110_queue_send_segment();
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Waits for the screen update in progress, if any.
+ *
+ * Must be called before any blocking SPI transfer.
+ */
+static void nokia5110_wait_idle(void) {
+    while (flush_phase != NOKIA5110_FLUSH_IDLE);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Gets the fastest SPI clock divider within NOKIA5110_SPI_MAX_HZ.
+ *
+ * @return Divider index.
+ */
+static uint8_t nokia5110_link_fastest(void) {
+    uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+
+    for (uint8_t i = 0; i < NOKIA5110_LINK_DIVIDERS_NR; i++) {
+        if (pclk / (2U << i) <= NOKIA5110_SPI_MAX_HZ) {
+            return i;
+        }
+    }
+
+    return NOKIA5110_LINK_DIVIDERS_NR - 1;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Changes the SPI clock, once the transfer in progress is done.
+ *
+ * @param divider_idx   Divider index.
+ */
+static void nokia5110_link_apply(uint8_t divider_idx) {
+    nokia5110_wait_idle();
+
+    link_divider_idx = divider_idx;
+    spi_handle.Init.BaudRatePrescaler = link_prescalers[divider_idx];
+    HAL_SPI_Init(&spi_handle);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sends a frame of test patterns at the current SPI clock.
+ *
+ * With NOKIA5110_LINK_LOOPBACK set, the bytes received on MISO must
+ * match the ones sent. Otherwise only the transfers are checked, the
+ * display can't be read.
+ *
+ * @return 1 if the whole frame went through, 0 otherwise.
+ */
+static uint8_t nokia5110_link_check(void) {
+    uint8_t received[sizeof(link_patterns)];
+    uint16_t sent = 0;
+
+    nokia5110_queue_reset();
+    nokia5110_queue_addr(0);
+    nokia5110_queue_drain_sync();
+
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
+    while (sent < NOKIA5110_BYTES_NR) {
+        uint16_t length = NOKIA5110_BYTES_NR - sent;
+
+        if (length > sizeof(link_patterns)) {
+            length = sizeof(link_patterns);
+        }
+
+        if (HAL_SPI_TransmitReceive(&spi_handle, (uint8_t*)link_patterns, received, length, NOKIA5110_SPI_TIMEOUT) != HAL_OK) {
+            break;
+        }
+
+#if (NOKIA5110_LINK_LOOPBACK == 1)
+        uint8_t mismatch = 0;
+
+        for (uint16_t i = 0; i < length; i++) {
+            mismatch |= received[i] ^ link_patterns[i];
+        }
+        if (mismatch != 0) {
+            break;
+        }
+#endif
+
+        sent += length;
+    }
+    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+
+    return (sent == NOKIA5110_BYTES_NR);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sets or clears the same pixels in consecutive columns.
+ *
+ * The snake cell widths, 2, 4 and 8 columns, take one 16 or 32 bit
+ * read-modify-write, or two, instead of a byte loop. The Cortex-M3
+ * handles unaligned word accesses, memcpy lets the compiler use them.
+ *
+ * @param column    First screen_buffer byte.
+ * @param width     Number of columns.
+ * @param mask      Pixels changed in each column.
+ * @param op        NOKIA5110_OP_OR to set them, NOKIA5110_OP_AND_NOT to clear them.
+ */
+static inline void nokia5110_write_columns(uint8_t* column, uint8_t width, uint8_t mask, nokia5110_op_t op) {
+    uint32_t masks = mask * 0x01010101UL;
+    uint32_t set = (op == NOKIA5110_OP_OR) ? masks : 0;
+    uint32_t keep = (op == NOKIA5110_OP_OR) ? 0xFFFFFFFFUL : ~masks;
+    uint32_t word;
+    uint16_t half;
+
+    switch (width) {
+        case 2:
+            memcpy(&half, column, sizeof(half));
+            half = (half | set) & keep;
+            memcpy(column, &half, sizeof(half));
+        break;
+        case 8:
+            memcpy(&word, column + 4, sizeof(word));
+            word = (word | set) & keep;
+            memcpy(column + 4, &word, sizeof(word));
+            // fall through
+        case 4:
+            memcpy(&word, column, sizeof(word));
+            word = (word | set) & keep;
+            memcpy(column, &word, sizeof(word));
+        break;
+        default:
+            for (uint8_t i = 0; i < width; i++) {
+                column[i] = (column[i] | set) & keep;
+            }
+        break;
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Merges bitmap bits into a screen_buffer byte.
+ *
+ * @param dest  screen_buffer byte.
+ * @param bits  Bitmap bits, aligned to the byte.
+ * @param mask  Pixels of the byte covered by the bitmap.
+ * @param op    Raster operation.
+ */
+static inline void nokia5110_write_byte(uint8_t* dest, uint8_t bits, uint8_t mask, nokia5110_op_t op) {
+    bits &= mask;
+
+    switch (op) {
+        case NOKIA5110_OP_OR:
+            *dest |= bits;
+        break;
+        case NOKIA5110_OP_AND_NOT:
+            *dest &= ~bits;
+        break;
+        case NOKIA5110_OP_XOR:
+            *dest ^= bits;
+        break;
+        case NOKIA5110_OP_COPY:
+            *dest = (*dest & ~mask) | bits;
+        break;
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Merges a bitmap into a rectangle of the screen_buffer.
+ *
+ * When y and height are multiples of 8, each bitmap byte maps to one
+ * screen_buffer byte. Otherwise each bitmap byte is shifted over two
+ * screen_buffer lines and merged with a mask.
+ *
+ * The rectangle is clipped to the screen.
+ *
+ * @param bitmap    Bitmap (see @ref nokia5110_blit) or NULL for a solid rectangle.
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Rectangle width in pixels.
+ * @param height    Rectangle height in pixels.
+ * @param op        Raster operation.
+ */
+static void nokia5110_raster(const uint8_t* bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height, nokia5110_op_t op) {
+    if (x >= NOKIA5110_MAX_COL_NR || y >= NOKIA5110_MAX_LINE_NR * 8 || width == 0 || height == 0) {
+        return;
+    }
+
+    uint8_t columns = width;
+    if (x + width > NOKIA5110_MAX_COL_NR) {
+        columns = NOKIA5110_MAX_COL_NR - x;
+    }
+
+    uint8_t bands = (height + 7) / 8;
+    uint8_t line = y / 8;
+    uint8_t shift = y % 8;
+
+    for (uint8_t band = 0; band < bands && line + band < NOKIA5110_MAX_LINE_NR; band++) {
+        const uint8_t* src = (bitmap != NULL) ? &bitmap[band * width] : NULL;
+        uint16_t buffer_pos = (line + band) * NOKIA5110_MAX_COL_NR + x;
+        uint8_t* dest = &back_buffer[buffer_pos];
+
+        if (shift == 0 && (height % 8) == 0) {
+            // Line aligned: byte to byte
+            for (uint8_t i = 0; i < columns; i++) {
+                nokia5110_write_byte(&dest[i], (src != NULL) ? src[i] : 0xFF, 0xFF, op);
+            }
+            nokia5110_mark_dirty_span(buffer_pos, columns);
+            continue;
+        }
+
+        uint8_t rows = height - band * 8;
+        if (rows > 8) {
+            rows = 8;
+        }
+        uint16_t mask = (uint16_t)(0xFF >> (8 - rows)) << shift;
+
+        for (uint8_t i = 0; i < columns; i++) {
+            uint16_t bits = (uint16_t)((src != NULL) ? src[i] : 0xFF) << shift;
+
+            nokia5110_write_byte(&dest[i], (uint8_t)bits, (uint8_t)mask, op);
+        }
+        nokia5110_mark_dirty_span(buffer_pos, columns);
+
+        if ((mask >> 8) == 0 || line + band + 1 >= NOKIA5110_MAX_LINE_NR) {
+            continue;
+        }
+
+        // Bits shifted into the next line
+        dest += NOKIA5110_MAX_COL_NR;
+        for (uint8_t i = 0; i < columns; i++) {
+            uint16_t bits = (uint16_t)((src != NULL) ? src[i] : 0xFF) << shift;
+
+            nokia5110_write_byte(&dest[i], (uint8_t)(bits >> 8), (uint8_t)(mask >> 8), op);
+        }
+        nokia5110_mark_dirty_span(buffer_pos + NOKIA5110_MAX_COL_NR, columns);
+    }
+}
 
 /* Public functions ----------------------------------------------------------*/
 /**
@@ -225,12 +835,29 @@ void nokia5110_setup(void) {
     spi_handle.Init.CLKPolarity = SPI_POLARITY_LOW;
     spi_handle.Init.CLKPhase = SPI_PHASE_1EDGE;
     spi_handle.Init.NSS = SPI_NSS_SOFT;
-    spi_handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128;
+    link_divider_idx = nokia5110_link_fastest();
+    spi_handle.Init.BaudRatePrescaler = link_prescalers[link_divider_idx];
     spi_handle.Init.FirstBit = SPI_FIRSTBIT_MSB;
     spi_handle.Init.TIMode = SPI_TIMODE_DISABLE;
     spi_handle.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
     HAL_SPI_Init(&spi_handle);
 
+    NOKIA5110_DMA_CLOCK_EN();
+
+    dma_handle.Instance = NOKIA5110_DMA_INSTANCE;
+    dma_handle.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    dma_handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    dma_handle.Init.MemInc = DMA_MINC_ENABLE;
+    dma_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    dma_handle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    dma_handle.Init.Mode = DMA_NORMAL;
+    dma_handle.Init.Priority = DMA_PRIORITY_LOW;
+    HAL_DMA_Init(&dma_handle);
+    __HAL_LINKDMA(&spi_handle, hdmatx, dma_handle);
+
+    HAL_NVIC_SetPriority(NOKIA5110_DMA_IRQ, NOKIA5110_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(NOKIA5110_DMA_IRQ);
+
     gpio_init.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_4;
     gpio_init.Mode = GPIO_MODE_OUTPUT_PP;
     gpio_init.Pull = GPIO_NOPULL;
@@ -247,98 +874,177 @@ void nokia5110_setup(void) {
     while (HAL_GetTick() - timeshot < NOKIA5110_RESET_PULSE_MS);
     HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_RST_PIN, GPIO_PIN_SET);
 
-    // LCD setup
-    // DC = 0 --> Command
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_RESET);
+    // LCD setup, sent in the same burst as the screen clearing
+    nokia5110_queue_reset();
+    nokia5110_queue_cmd(NOKIA5110_CMD_FUNC_SET | NOKIA5110_CMD_POWER_EN | NOKIA5110_CMD_HORIZONTAL_ADDR | NOKIA5110_CMD_INSTR_SET_EXTENDED);
+    nokia5110_queue_cmd(NOKIA5110_CMD_VOP | NOKIA5110_CMD_DEFAULT_CONTRAST);
 
-    uint8_t buffer[4] = { 0 };
-    buffer[0] = NOKIA5110_CMD_FUNC_SET | NOKIA5110_CMD_POWER_EN | NOKIA5110_CMD_HORIZONTAL_ADDR | NOKIA5110_CMD_INSTR_SET_EXTENDED;
-    buffer[1] = NOKIA5110_CMD_VOP | NOKIA5110_CMD_DEFAULT_CONTRAST;
+    nokia5110_queue_cmd(NOKIA5110_CMD_FUNC_SET | NOKIA5110_CMD_POWER_EN | NOKIA5110_CMD_HORIZONTAL_ADDR | NOKIA5110_CMD_INSTR_SET_BASIC);
+    nokia5110_queue_cmd(NOKIA5110_CMD_DISPLAY_CONTROL | NOKIA5110_CMD_MODE_NORMAL);
 
-    buffer[2] = NOKIA5110_CMD_FUNC_SET | NOKIA5110_CMD_POWER_EN | NOKIA5110_CMD_HORIZONTAL_ADDR | NOKIA5110_CMD_INSTR_SET_BASIC;
-    buffer[3] = NOKIA5110_CMD_DISPLAY_CONTROL | NOKIA5110_CMD_MODE_NORMAL;
+    nokia5110_queue_blank_frame();
+    nokia5110_queue_drain_sync();
 
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(&spi_handle, buffer, 4, NOKIA5110_SPI_TIMEOUT);
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+#if (NOKIA5110_LINK_LOOPBACK == 1)
+    nokia5110_link_test(NULL);
+#endif
 
-    nokia5110_clear_screen();
     nokia5110_move_cursor(0, 0);
 }
 
 /**
  * @ingroup nokia5110
- * @brief Move display cursor.
+ * @brief Sets the SPI clock divider.
+ *
+ * Waits for the screen update in progress, if any.
+ *
+ * @param divider   PCLK2 divider, a power of two from 2 to 256.
+ *
+ * @return 1 if set, 0 if the divider is invalid.
+ */
+uint8_t nokia5110_set_link_divider(uint16_t divider) {
+    for (uint8_t i = 0; i < NOKIA5110_LINK_DIVIDERS_NR; i++) {
+        if ((2U << i) == divider) {
+            nokia5110_link_apply(i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Gets the SPI clock divider.
+ */
+uint16_t nokia5110_get_link_divider(void) {
+    return 2U << link_divider_idx;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Gets the SPI clock (in Hz).
+ */
+uint32_t nokia5110_get_link_rate(void) {
+    return HAL_RCC_GetPCLK2Freq() / nokia5110_get_link_divider();
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Tunes the SPI clock.
+ *
+ * Sends a frame of test patterns at each divider, from the fastest
+ * within NOKIA5110_SPI_MAX_HZ to the slowest, and keeps the fastest one
+ * that passed (the slowest if none did). The PCD8544 has no data output,
+ * so the patterns are only read back with MISO wired to MOSI (see
+ * NOKIA5110_LINK_LOOPBACK), which checks the MCU side of the link.
+ * Otherwise every divider whose transfers complete passes, and the
+ * results are marked as not verified.
+ *
+ * The screen is cleared at the end, and the whole frame is sent again on
+ * the next update.
+ *
+ * @param results   Result of each divider tested, fastest first, up to
+ *                  NOKIA5110_LINK_DIVIDERS_NR. May be NULL.
+ *
+ * @return Number of dividers tested.
+ */
+uint8_t nokia5110_link_test(nokia5110_link_result_t* results) {
+    uint8_t best = NOKIA5110_LINK_DIVIDERS_NR;
+    uint8_t result_nr = 0;
+
+    for (uint8_t i = nokia5110_link_fastest(); i < NOKIA5110_LINK_DIVIDERS_NR; i++) {
+        nokia5110_link_apply(i);
+
+        uint8_t passed = nokia5110_link_check();
+        if (passed != 0 && best == NOKIA5110_LINK_DIVIDERS_NR) {
+            best = i;
+        }
+
+        if (results != NULL) {
+            results[result_nr].divider = 2U << i;
+            results[result_nr].rate_hz = nokia5110_get_link_rate();
+            results[result_nr].passed = passed;
+            results[result_nr].verified = NOKIA5110_LINK_LOOPBACK;
+        }
+        result_nr++;
+    }
+
+    if (best == NOKIA5110_LINK_DIVIDERS_NR) {
+        best = NOKIA5110_LINK_DIVIDERS_NR - 1;
+    }
+    nokia5110_link_apply(best);
+
+    nokia5110_queue_reset();
+    nokia5110_queue_blank_frame();
+    nokia5110_queue_drain_sync();
+
+    return result_nr;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Move the text cursor.
  *
  * The display pixels are organized vertically in groups of 8.
  * This results in 84 columns and only 6 lines, each line with
- * 8 pixels.
+ * 8 pixels. Text is written in lines.
  *
  * @param x     Column (from 0 to 83).
  * @param y     Line (from 0 to 5).
  */
 void nokia5110_move_cursor(uint8_t x, uint8_t y) {
-    // Updates display position to copy the sent chars on screen buffer
-    display_pos = x + y * NOKIA5110_MAX_COL_NR;
-
-    // DC = 0 --> Command
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_RESET);
-
-    uint8_t buffer[2] = {0};
-    buffer[0] = NOKIA5110_CMD_Y_ADDR | y; // Line
-    buffer[1] = NOKIA5110_CMD_X_ADDR | x; // Column
-
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(&spi_handle, buffer, 2, NOKIA5110_SPI_TIMEOUT);
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+    text_x = x;
+    text_line = y;
 }
 
 /**
  * @ingroup nokia5110
  * @brief Clear all display pixels.
  *
- * @note Doesn't write to the screen_buffer.
+ * @note Doesn't write to the screen_buffer, but flags it all to be sent
+ * again on the next @ref nokia5110_update_screen.
  */
 void nokia5110_clear_screen(void) {
-    nokia5110_move_cursor(0, 0);
-
-    // DC = 1 --> Data
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_SET);
+    nokia5110_wait_idle();
 
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
-    for (uint16_t i = 0; i < NOKIA5110_BYTES_NR; i++) {
-        uint8_t buffer = 0;
-        HAL_SPI_Transmit(&spi_handle, &buffer, 1, NOKIA5110_SPI_TIMEOUT);
-    }
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+    nokia5110_queue_reset();
+    nokia5110_queue_blank_frame();
+    nokia5110_queue_drain_sync();
 }
 
 /**
  * @ingroup nokia5110
- * @brief Writes a character to the screen.
+ * @brief Writes a character to the screen_buffer at the text cursor.
+ *
+ * Each character takes 5 columns plus 1 blank column. Characters
+ * past the end of the line are clipped, and characters without a
+ * glyph are written as a space.
  *
  * @param character     Character to print.
  *
- * @note Updates the screen_buffer, display_pos and the screen itself.
- * The screen_buffer update is needed to keep the character on the screen
- * after the execution of @ref nokia5110_update_screen.
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_char to actually update the screen.
  */
 void nokia5110_char(char character) {
-    // Adds 1 blank column after the char (buffer == 0)
-    uint8_t buffer[NOKIA5110_COL_PER_CHAR + 1] = { 0 };
+    // Adds 1 blank column after the char (glyph == 0)
+    uint8_t glyph[NOKIA5110_COL_PER_CHAR + 1] = { 0 };
+    uint8_t code = (uint8_t)character;
+
+    if (text_x >= NOKIA5110_MAX_COL_NR) {
+        return;
+    }
+
+    if (code < NOKIA5110_FIRST_CHAR_VALUE || code >= NOKIA5110_FIRST_CHAR_VALUE + NOKIA5110_CHARS_NR) {
+        code = ' ';
+    }
 
-    // DC = 1 --> Data
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_SET);
     for (uint8_t i = 0; i < NOKIA5110_COL_PER_CHAR; i++) {
-        buffer[i] = characters[character - NOKIA5110_FIRST_CHAR_VALUE][i];
-        screen_buffer[display_pos++] = buffer[i];
+        glyph[i] = characters[code - NOKIA5110_FIRST_CHAR_VALUE][i];
     }
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(&spi_handle, buffer, NOKIA5110_COL_PER_CHAR + 1, NOKIA5110_SPI_TIMEOUT);
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
 
-    // Keeps count of the added blank column
-    screen_buffer[display_pos++] = 0;
+    nokia5110_raster(glyph, text_x, text_line * 8, NOKIA5110_COL_PER_CHAR + 1, 8, NOKIA5110_OP_COPY);
+    text_x += NOKIA5110_COL_PER_CHAR + 1;
 }
 
 /**
@@ -385,16 +1091,173 @@ void nokia5110_string_at(char* string, uint8_t x, uint8_t y) {
 /**
  * @ingroup nokia5110
  * @brief Writes the screen_buffer to the display.
+ *
+ * Blocking version of @ref nokia5110_present.
  */
 void nokia5110_update_screen(void) {
-    nokia5110_move_cursor(0, 0);
-    
-    // DC = 1 --> Data
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_DC_PIN, GPIO_PIN_SET);
+    nokia5110_present();
+    nokia5110_wait_idle();
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Swaps the frame buffers and starts sending the new front one.
+ *
+ * The back buffer, with everything drawn since the last call, becomes
+ * the front buffer and is read by DMA while the drawing functions write
+ * to the new back buffer, so the transfer and the next frame drawing
+ * don't tear each other.
+ *
+ * Only the bytes changed since the last update are sent, grouped in
+ * spans. Clean gaps up to NOKIA5110_DIRTY_GAP_MAX bytes are sent within
+ * the span, since a new span costs 2 addressing bytes. The same spans
+ * are copied to the new back buffer, which is one frame behind, instead
+ * of copying the whole frame.
+ *
+ * The span addresses and bytes are queued and sent in a single CS
+ * asserted burst, switching DC only between address and data segments.
+ * With NOKIA5110_USE_DMA set to 0 the queue is sent with blocking
+ * transfers instead.
+ *
+ * The function returns right after the first transfer starts. If an
+ * update is still in progress, waits for it before swapping. Use
+ * @ref nokia5110_is_busy or @ref nokia5110_update_cplt_callback to know
+ * when it finishes.
+ */
+void nokia5110_present(void) {
+    uint16_t pos = 0;
+
+    nokia5110_wait_idle();
+
+    nokia5110_queue_reset();
+    flush_span_nr = 0;
+
+    while (pos < NOKIA5110_BYTES_NR) {
+        if (nokia5110_is_dirty(pos) == 0) {
+            // Skips whole clean words
+            if ((pos % 32) == 0 && dirty_map[pos / 32] == 0) {
+                pos += 32;
+            } else {
+                pos++;
+            }
+            continue;
+        }
+
+        uint16_t start = pos;
+        uint16_t end = pos + 1;
+
+        for (pos = end; pos < NOKIA5110_BYTES_NR; pos++) {
+            if (nokia5110_is_dirty(pos) != 0) {
+                end = pos + 1;
+            } else if (pos - end >= NOKIA5110_DIRTY_GAP_MAX) {
+                break;
+            }
+        }
+
+        nokia5110_queue_span(start, end);
+    }
+
+    for (uint8_t i = 0; i < NOKIA5110_DIRTY_WORDS; i++) {
+        dirty_map[i] = 0;
+    }
+
+    uint8_t* drawn_buffer = back_buffer;
+    back_buffer = front_buffer;
+    front_buffer = drawn_buffer;
+
+    // Brings the new back buffer up to date
+    for (uint8_t i = 0; i < flush_span_nr; i++) {
+        uint16_t end = flush_spans[i].start + flush_spans[i].length;
+
+        for (uint16_t j = flush_spans[i].start; j < end; j++) {
+            back_buffer[j] = front_buffer[j];
+        }
+    }
+
+    for (uint8_t i = 0; i < flush_span_nr; i++) {
+        nokia5110_queue_addr(flush_spans[i].start);
+        nokia5110_queue_data(&front_buffer[flush_spans[i].start], flush_spans[i].length);
+    }
+    frame_stats.spans = flush_span_nr;
+
+#if (NOKIA5110_USE_DMA == 1)
+    nokia5110_queue_drain_dma();
+#else
+    nokia5110_queue_drain_sync();
+    nokia5110_update_cplt_callback();
+#endif
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Checks if a screen update is in progress.
+ *
+ * @return 1 while the DMA transfer is running, 0 otherwise.
+ */
+uint8_t nokia5110_is_busy(void) {
+    return flush_phase != NOKIA5110_FLUSH_IDLE;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Screen update completed callback.
+ *
+ * Called from the DMA interrupt when the last span was sent. Override
+ * it to be notified without polling @ref nokia5110_is_busy.
+ */
+__weak void nokia5110_update_cplt_callback(void) {
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Handles the display DMA channel interrupt.
+ *
+ * Must be called from the DMA1_Channel3 IRQ handler.
+ */
+void nokia5110_dma_irq_handler(void) {
+    HAL_DMA_IRQHandler(&dma_handle);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief SPI transfer completed callback.
+ *
+ * Sends the next queue segment of the screen update. Releases CS
+ * after the last one.
+ *
+ * @param hspi  SPI handle.
+ */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi) {
+    if (hspi != &spi_handle) {
+        return;
+    }
+
+    if (++queue_segment_idx < queue_segment_nr) {
+        nokia5110_queue_send_segment();
+    } else {
+        HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+        flush_phase = NOKIA5110_FLUSH_IDLE;
+        nokia5110_update_cplt_callback();
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief SPI error callback.
+ *
+ * Aborts the screen update in progress and flags the whole
+ * screen_buffer to be sent again on the next update.
+ *
+ * @param hspi  SPI handle.
+ */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi) {
+    if (hspi != &spi_handle) {
+        return;
+    }
 
-    HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(&spi_handle, screen_buffer, NOKIA5110_BYTES_NR, NOKIA5110_SPI_TIMEOUT);
     HAL_GPIO_WritePin(NOKIA5110_GPIO_PORT, NOKIA5110_CS_PIN, GPIO_PIN_SET);
+    nokia5110_mark_all_dirty();
+    flush_phase = NOKIA5110_FLUSH_IDLE;
 }
 
 /**
@@ -403,8 +1266,9 @@ void nokia5110_update_screen(void) {
  */
 void nokia5110_clear_buffer(void) {
     for (uint16_t i = 0; i < NOKIA5110_BYTES_NR; i++) {
-        screen_buffer[i] = 0;
+        back_buffer[i] = 0;
     }
+    nokia5110_mark_all_dirty();
 }
 
 /**
@@ -420,7 +1284,8 @@ void nokia5110_clear_buffer(void) {
 void nokia5110_set_pixel(uint8_t x, uint8_t y) {
     uint16_t buffer_pos = (y / 8) * NOKIA5110_MAX_COL_NR + x;
 
-    screen_buffer[buffer_pos] |= (1 << (y % 8));
+    back_buffer[buffer_pos] |= (1 << (y % 8));
+    nokia5110_mark_dirty(buffer_pos);
 }
 
 /**
@@ -436,7 +1301,98 @@ void nokia5110_set_pixel(uint8_t x, uint8_t y) {
 void nokia5110_clr_pixel(uint8_t x, uint8_t y) {
     uint16_t buffer_pos = (y / 8) * NOKIA5110_MAX_COL_NR + x;
 
-    screen_buffer[buffer_pos] &= ~(1 << (y % 8));
+    back_buffer[buffer_pos] &= ~(1 << (y % 8));
+    nokia5110_mark_dirty(buffer_pos);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sets pixels of consecutive columns on a line and the next one.
+ *
+ * The block primitives with the buffer position and the line masks
+ * worked out by the caller, e.g. from a lookup table.
+ *
+ * @param buffer_pos    screen_buffer index of the first column.
+ * @param width         Number of columns. NOTE: must not cross the line end.
+ * @param mask          Pixels set in each column of the line.
+ * @param next_mask     Pixels set in each column of the next line, 0 for none.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_set_columns to actually update the screen.
+ */
+void nokia5110_set_columns(uint16_t buffer_pos, uint8_t width, uint8_t mask, uint8_t next_mask) {
+    nokia5110_write_columns(&back_buffer[buffer_pos], width, mask, NOKIA5110_OP_OR);
+    nokia5110_mark_dirty_span(buffer_pos, width);
+
+    if (next_mask != 0) {
+        nokia5110_write_columns(&back_buffer[buffer_pos + NOKIA5110_MAX_COL_NR], width, next_mask, NOKIA5110_OP_OR);
+        nokia5110_mark_dirty_span(buffer_pos + NOKIA5110_MAX_COL_NR, width);
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Clears pixels of consecutive columns on a line and the next one.
+ *
+ * Same as @ref nokia5110_set_columns, ANDing the inverted masks.
+ *
+ * @param buffer_pos    screen_buffer index of the first column.
+ * @param width         Number of columns. NOTE: must not cross the line end.
+ * @param mask          Pixels cleared in each column of the line.
+ * @param next_mask     Pixels cleared in each column of the next line, 0 for none.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_clr_columns to actually update the screen.
+ */
+void nokia5110_clr_columns(uint16_t buffer_pos, uint8_t width, uint8_t mask, uint8_t next_mask) {
+    nokia5110_write_columns(&back_buffer[buffer_pos], width, mask, NOKIA5110_OP_AND_NOT);
+    nokia5110_mark_dirty_span(buffer_pos, width);
+
+    if (next_mask != 0) {
+        nokia5110_write_columns(&back_buffer[buffer_pos + NOKIA5110_MAX_COL_NR], width, next_mask, NOKIA5110_OP_AND_NOT);
+        nokia5110_mark_dirty_span(buffer_pos + NOKIA5110_MAX_COL_NR, width);
+    }
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sets all pixels of a block up to 8 pixels tall on the screen_buffer.
+ *
+ * A block that short covers at most 2 lines, so its pixels are set by
+ * ORing the same column mask into each covered screen_buffer byte.
+ *
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Block width in pixels. NOTE: x + width must not exceed 84.
+ * @param height    Block height in pixels (from 1 to 8).
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_set_block to actually update the screen.
+ */
+void nokia5110_set_block(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    uint16_t mask = ((1 << height) - 1) << (y % 8);
+
+    nokia5110_set_columns((y / 8) * NOKIA5110_MAX_COL_NR + x, width, (uint8_t)mask, (uint8_t)(mask >> 8));
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Clears all pixels of a block up to 8 pixels tall on the screen_buffer.
+ *
+ * Same as @ref nokia5110_set_block, ANDing the inverted column mask.
+ *
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Block width in pixels. NOTE: x + width must not exceed 84.
+ * @param height    Block height in pixels (from 1 to 8).
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_clr_block to actually update the screen.
+ */
+void nokia5110_clr_block(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    uint16_t mask = ((1 << height) - 1) << (y % 8);
+
+    nokia5110_clr_columns((y / 8) * NOKIA5110_MAX_COL_NR + x, width, (uint8_t)mask, (uint8_t)(mask >> 8));
 }
 
 /**
@@ -492,3 +1448,83 @@ void nokia5110_clear_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
         nokia5110_clr_pixel(x2, i);
     }
 }
+
+/**
+ * @ingroup nokia5110
+ * @brief Gets the transfer statistics of the last screen update.
+ *
+ * @param stats     Output statistics.
+ */
+void nokia5110_get_stats(nokia5110_stats_t* stats) {
+    *stats = frame_stats;
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Sets all pixels of a rectangle on the screen_buffer.
+ *
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Rectangle width in pixels.
+ * @param height    Rectangle height in pixels.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_fill_rect to actually update the screen.
+ */
+void nokia5110_fill_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    nokia5110_raster(NULL, x, y, width, height, NOKIA5110_OP_OR);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Clears all pixels of a rectangle on the screen_buffer.
+ *
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Rectangle width in pixels.
+ * @param height    Rectangle height in pixels.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_erase_rect to actually update the screen.
+ */
+void nokia5110_erase_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    nokia5110_raster(NULL, x, y, width, height, NOKIA5110_OP_AND_NOT);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Inverts all pixels of a rectangle on the screen_buffer.
+ *
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Rectangle width in pixels.
+ * @param height    Rectangle height in pixels.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_invert_rect to actually update the screen.
+ */
+void nokia5110_invert_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    nokia5110_raster(NULL, x, y, width, height, NOKIA5110_OP_XOR);
+}
+
+/**
+ * @ingroup nokia5110
+ * @brief Draws a bitmap on the screen_buffer.
+ *
+ * The bitmap uses the display layout: each byte is a column of 8
+ * pixels, LSB on top, and each group of 8 rows takes width bytes.
+ * Its size is width * ((height + 7) / 8) bytes.
+ *
+ * @param bitmap    Bitmap bytes.
+ * @param x         Top left corner x coordinate (from 0 to 83).
+ * @param y         Top left corner y coordinate (from 0 to 47).
+ * @param width     Bitmap width in pixels.
+ * @param height    Bitmap height in pixels.
+ * @param op        How the bitmap pixels are merged with the screen_buffer.
+ *
+ * @note The function @ref nokia5110_update_screen must be executed
+ * after @ref nokia5110_blit to actually update the screen.
+ */
+void nokia5110_blit(const uint8_t* bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height, nokia5110_op_t op) {
+    nokia5110_raster(bitmap, x, y, width, height, op);
+}
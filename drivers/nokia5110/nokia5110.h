@@ -15,7 +15,48 @@
 #define NOKIA5110_MAX_COL_NR    84
 #define NOKIA5110_BYTES_NR      504
 
+/** SPI clock dividers, from PCLK2 / 2 to PCLK2 / 256. */
+#define NOKIA5110_LINK_DIVIDERS_NR  8
+
+/**
+ * @ingroup nokia5110
+ * @brief Raster operations of @ref nokia5110_blit.
+ */
+typedef enum {
+    NOKIA5110_OP_OR = 0,    /**< Sets the pixels set in the bitmap. */
+    NOKIA5110_OP_AND_NOT,   /**< Clears the pixels set in the bitmap. */
+    NOKIA5110_OP_XOR,       /**< Inverts the pixels set in the bitmap. */
+    NOKIA5110_OP_COPY,      /**< Replaces the rectangle with the bitmap. */
+} nokia5110_op_t;
+
+/**
+ * @ingroup nokia5110
+ * @brief Transfer statistics of the last display transfer.
+ */
+typedef struct {
+    uint16_t data_bytes;    /**< Frame bytes sent (DC = 1). */
+    uint16_t cmd_bytes;     /**< Command bytes sent (DC = 0). */
+    uint8_t spans;          /**< Number of contiguous spans sent. */
+    uint8_t segments;       /**< Number of command/data segments (DC switches + 1). */
+    uint8_t bursts;         /**< Number of CS asserted bursts. */
+} nokia5110_stats_t;
+
+/**
+ * @ingroup nokia5110
+ * @brief Link test result at a SPI clock divider.
+ */
+typedef struct {
+    uint16_t divider;       /**< SPI clock divider. */
+    uint32_t rate_hz;       /**< SPI clock (PCLK2 / divider). */
+    uint8_t passed;         /**< 1 if the test patterns went through. */
+    uint8_t verified;       /**< 1 if they were read back (NOKIA5110_LINK_LOOPBACK), 0 if only the transfers were checked. */
+} nokia5110_link_result_t;
+
 void nokia5110_setup(void);
+uint8_t nokia5110_set_link_divider(uint16_t divider);
+uint16_t nokia5110_get_link_divider(void);
+uint32_t nokia5110_get_link_rate(void);
+uint8_t nokia5110_link_test(nokia5110_link_result_t* results);
 void nokia5110_move_cursor(uint8_t x, uint8_t y);
 void nokia5110_clear_screen(void);
 void nokia5110_char(char character);
@@ -23,10 +64,23 @@ void nokia5110_char_at(char character, uint8_t x, uint8_t y);
 void nokia5110_string(char* string);
 void nokia5110_string_at(char* string, uint8_t x, uint8_t y);
 void nokia5110_update_screen(void);
+void nokia5110_present(void);
+uint8_t nokia5110_is_busy(void);
+void nokia5110_update_cplt_callback(void);
+void nokia5110_dma_irq_handler(void);
 void nokia5110_clear_buffer(void);
 void nokia5110_set_pixel(uint8_t x, uint8_t y);
 void nokia5110_clr_pixel(uint8_t x, uint8_t y);
+void nokia5110_set_block(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+void nokia5110_clr_block(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+void nokia5110_set_columns(uint16_t buffer_pos, uint8_t width, uint8_t mask, uint8_t next_mask);
+void nokia5110_clr_columns(uint16_t buffer_pos, uint8_t width, uint8_t mask, uint8_t next_mask);
+void nokia5110_fill_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+void nokia5110_erase_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+void nokia5110_invert_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+void nokia5110_blit(const uint8_t* bitmap, uint8_t x, uint8_t y, uint8_t width, uint8_t height, nokia5110_op_t op);
 void nokia5110_draw_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
 void nokia5110_clear_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
+void nokia5110_get_stats(nokia5110_stats_t* stats);
 
 #endif /* NOKIA5110_H */
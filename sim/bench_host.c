@@ -0,0 +1,45 @@
+/**
+ * @file
+ * @brief Host benchmarks.
+ *
+ * Runs the benchmarks (see @ref bench) on the host simulator build,
+ * timed with the monotonic clock.
+ *
+ * Usage: snake_bench [-f csv|json]
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "bench.h"
+#include "nokia5110.h"
+
+#include "stm32f1xx_hal.h"
+#include "hal_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief Main function.
+ */
+int main(int argc, char* argv[]) {
+    bench_format_t format = BENCH_FORMAT_CSV;
+    int option;
+
+    while ((option = getopt(argc, argv, "f:")) != -1) {
+        if (option == 'f' && strcmp(optarg, "csv") == 0) {
+            format = BENCH_FORMAT_CSV;
+        } else if (option == 'f' && strcmp(optarg, "json") == 0) {
+            format = BENCH_FORMAT_JSON;
+        } else {
+            fprintf(stderr, "usage: %s [-f csv|json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sim_reset();
+    nokia5110_setup();
+    bench_run(format);
+
+    return 0;
+}
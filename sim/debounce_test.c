@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief Debounce trace checker.
+ *
+ * Feeds recorded key samples to the debounce (see @ref debounce) and
+ * checks the debounced levels and the stable flag after each one.
+ *
+ * Usage: debounce_test trace...
+ *
+ * Each trace line holds a sample of the four keys, the debounced levels
+ * expected after it (hex, bit 0 is the right key, see
+ * @ref KEYBOARD_KEY_MASK) and 1 if no key is in the middle of a change,
+ * 0 otherwise, e.g. "3 1 0". The debounce starts with all the keys
+ * released, or with the levels of an "init" line. Lines starting with
+ * '#' are ignored.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "debounce.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static int debounce_test_run(const char* path);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @brief Checks a trace.
+ *
+ * @param path  Trace file.
+ *
+ * @return Number of failed samples, -1 if the trace can't be read.
+ */
+static int debounce_test_run(const char* path) {
+    FILE* file = fopen(path, "r");
+    char line[128];
+    debounce_t debounce;
+    unsigned sample_no = 0;
+    int failed = 0;
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    debounce_init(&debounce, 0);
+    for (unsigned line_no = 1; fgets(line, sizeof(line), file) != NULL; line_no++) {
+        unsigned sample, state, stable;
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "init %x", &state) == 1) {
+            debounce_init(&debounce, state);
+            continue;
+        }
+        if (sscanf(line, "%x %x %u", &sample, &state, &stable) != 3) {
+            fprintf(stderr, "%s:%u: bad line\n", path, line_no);
+            fclose(file);
+            return -1;
+        }
+
+        debounce_update(&debounce, sample);
+        sample_no++;
+        if (debounce.state != state || debounce_is_stable(&debounce) != stable) {
+            fprintf(stderr, "%s:%u: sample %x gave %x %u, expected %x %u\n", path, line_no,
+                    sample, (unsigned)debounce.state, debounce_is_stable(&debounce), state, stable);
+            failed++;
+        }
+    }
+
+    fclose(file);
+    printf("%s: %u samples, %d failed\n", path, sample_no, failed);
+    return failed;
+}
+
+/* Public functions ----------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    int status = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace...\n", argv[0]);
+        return 2;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        int failed = debounce_test_run(argv[i]);
+
+        if (failed < 0) {
+            fprintf(stderr, "debounce_test: can't read %s\n", argv[i]);
+        }
+        if (failed != 0) {
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,746 @@
+/**
+ * @file
+ * @ingroup sim_hal
+ * @brief Host HAL stand-in implementation.
+ *
+ * The virtual clock only moves when the simulator advances it, plus one
+ * microsecond on each HAL_GetTick call, so busy-wait loops terminate and
+ * a run is fully reproducible.
+ *
+ * Every SPI byte is recorded with the DC and CS levels and fed to a
+ * PCD8544 model, which keeps its own display RAM and address counters.
+ * DMA transfers complete immediately, calling the completion callback
+ * before HAL_SPI_Transmit_DMA returns.
+ *
+ * A started timer raises its update interrupt each time the clock
+ * crosses a period, either from @ref sim_advance_us or from Sleep mode,
+ * which jumps to the next timer interrupt.
+ *
+ * Sleep mode moves the clock in 1 ms steps up to the next timer
+ * interrupt, and Stop mode in 1 ms steps with the timer frozen. Both
+ * call @ref sim_stop_hook on each step until a key EXTI line fires.
+ * Key EXTI interrupts run as soon as the pins change, since interrupts
+ * are never masked here.
+ * The RTC counts 1024 Hz of virtual time, its prescaler the LSE periods
+ * in between, and the cycle counter counts the time out of Sleep and
+ * Stop at the core clock, which is HSI after a Stop mode wake up until
+ * HAL_RCC_ClockConfig.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include "hal_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SIM_LCD_BANKS       (SIM_LCD_HEIGHT / 8)
+#define SIM_LCD_RAM_SIZE    (SIM_LCD_WIDTH * SIM_LCD_BANKS)
+
+// Display wiring, see nokia5110.c
+#define SIM_LCD_PORT        GPIOA
+#define SIM_LCD_DC_PIN      GPIO_PIN_0
+#define SIM_LCD_RST_PIN     GPIO_PIN_1
+#define SIM_LCD_CS_PIN      GPIO_PIN_4
+
+// PCD8544 instructions
+#define SIM_CMD_FUNC_SET    0x20
+#define SIM_CMD_FUNC_PD     0x04
+#define SIM_CMD_FUNC_V      0x02
+#define SIM_CMD_FUNC_H      0x01
+#define SIM_CMD_DISPLAY     0x08
+#define SIM_CMD_DISPLAY_D   0x04
+#define SIM_CMD_DISPLAY_E   0x01
+#define SIM_CMD_Y_ADDR      0x40
+#define SIM_CMD_X_ADDR      0x80
+
+// Virtual time spent by each HAL_GetTick call
+#define SIM_POLL_COST_US    1
+
+// Clocks set by clock_config: 72 MHz core, APB1 and APB2 at 36 MHz, timers at 72 MHz
+#define SIM_CORE_CLOCK_HZ   72000000
+#define SIM_PCLK1_HZ        36000000
+#define SIM_PCLK2_HZ        36000000
+#define SIM_TIM_CLOCK_MHZ   72
+
+// RTC clocked by LSE / 32
+#define SIM_LSE_HZ          32768
+#define SIM_RTC_HZ          1024
+
+// Rough HSE start up plus PLL lock time, spent by HAL_RCC_OscConfig
+#define SIM_PLL_START_US    1500
+
+// Virtual time step while in Stop mode
+#define SIM_STOP_STEP_US    1000
+
+/* Private types -------------------------------------------------------------*/
+/**
+ * @ingroup sim_hal
+ * @brief PCD8544 controller state.
+ */
+typedef struct {
+    uint8_t ram[SIM_LCD_RAM_SIZE];  /**< Display data RAM. */
+    uint8_t x;                      /**< Column address. */
+    uint8_t y;                      /**< Bank address. */
+    uint8_t function;               /**< Last function set flags (PD, V, H). */
+    uint8_t display;                /**< Last display control flags (D, E). */
+} sim_lcd_t;
+
+/* Public variables ----------------------------------------------------------*/
+GPIO_TypeDef sim_gpioa = { 0 };
+GPIO_TypeDef sim_gpiob = { 0xFFFF, 0 };
+DWT_Type sim_dwt = { 0 };
+CoreDebug_Type sim_core_debug = { 0 };
+RTC_TypeDef sim_rtc = { 0 };
+uint32_t SystemCoreClock = SIM_CORE_CLOCK_HZ;
+
+/* Private variables ---------------------------------------------------------*/
+static uint64_t time_us = 0;
+static uint32_t core_mhz = SIM_CORE_CLOCK_HZ / 1000000;
+static uint64_t nvic_enabled = 0;
+
+static uint16_t exti_falling = 0;
+static uint16_t exti_rising = 0;
+static uint16_t exti_pending = 0;
+static uint8_t exti_wake = 0;
+static sim_lcd_t lcd = { 0 };
+
+static TIM_HandleTypeDef* tim = NULL;
+static uint64_t tim_period_us = 0;
+static uint64_t tim_next_us = 0;
+
+static sim_spi_record_t* spi_records = NULL;
+static size_t spi_record_nr = 0;
+static size_t spi_record_cap = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void sim_lcd_reset(void);
+static void sim_lcd_command(uint8_t command);
+static void sim_lcd_data(uint8_t data);
+static void sim_spi_shift(const uint8_t* data, uint16_t size);
+static void sim_run_until(uint64_t until_us);
+static void sim_idle_until(uint64_t until_us);
+static void sim_update_clocks(uint64_t until_us, uint8_t running);
+static void sim_exti_raise(void);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @ingroup sim_hal
+ * @brief Resets the PCD8544 model (RST pulse).
+ */
+static void sim_lcd_reset(void) {
+    memset(&lcd, 0, sizeof(lcd));
+    lcd.function = SIM_CMD_FUNC_PD;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Executes a PCD8544 instruction.
+ *
+ * Only addressing, function set and display control are modeled.
+ * Extended instructions (bias, contrast, temperature) are ignored.
+ *
+ * @param command   Instruction byte (DC = 0).
+ */
+static void sim_lcd_command(uint8_t command) {
+    if ((command & 0xF8) == SIM_CMD_FUNC_SET) {
+        lcd.function = command & (SIM_CMD_FUNC_PD | SIM_CMD_FUNC_V | SIM_CMD_FUNC_H);
+        return;
+    }
+
+    if (lcd.function & SIM_CMD_FUNC_H) {
+        // Extended instruction set
+        return;
+    }
+
+    if (command & SIM_CMD_X_ADDR) {
+        lcd.x = command & 0x7F;
+        if (lcd.x >= SIM_LCD_WIDTH) {
+            lcd.x = 0;
+        }
+    } else if (command & SIM_CMD_Y_ADDR) {
+        lcd.y = command & 0x07;
+        if (lcd.y >= SIM_LCD_BANKS) {
+            lcd.y = 0;
+        }
+    } else if ((command & 0xF8) == SIM_CMD_DISPLAY) {
+        lcd.display = command & (SIM_CMD_DISPLAY_D | SIM_CMD_DISPLAY_E);
+    }
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Writes a byte to the display RAM and moves the address.
+ *
+ * @param data  Data byte (DC = 1).
+ */
+static void sim_lcd_data(uint8_t data) {
+    lcd.ram[lcd.y * SIM_LCD_WIDTH + lcd.x] = data;
+
+    if (lcd.function & SIM_CMD_FUNC_V) {
+        if (++lcd.y == SIM_LCD_BANKS) {
+            lcd.y = 0;
+            if (++lcd.x == SIM_LCD_WIDTH) {
+                lcd.x = 0;
+            }
+        }
+    } else {
+        if (++lcd.x == SIM_LCD_WIDTH) {
+            lcd.x = 0;
+            if (++lcd.y == SIM_LCD_BANKS) {
+                lcd.y = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Records SPI bytes and feeds them to the display model.
+ *
+ * @param data  Bytes sent.
+ * @param size  Number of bytes.
+ */
+static void sim_spi_shift(const uint8_t* data, uint16_t size) {
+    uint8_t dc = (SIM_LCD_PORT->ODR & SIM_LCD_DC_PIN) != 0;
+    uint8_t cs = (SIM_LCD_PORT->ODR & SIM_LCD_CS_PIN) != 0;
+
+    if (spi_record_nr + size > spi_record_cap) {
+        size_t cap = spi_record_cap ? spi_record_cap : 4096;
+
+        while (cap < spi_record_nr + size) {
+            cap *= 2;
+        }
+        spi_records = realloc(spi_records, cap * sizeof(*spi_records));
+        if (spi_records == NULL) {
+            fprintf(stderr, "sim: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        spi_record_cap = cap;
+    }
+
+    for (uint16_t i = 0; i < size; i++) {
+        sim_spi_record_t* record = &spi_records[spi_record_nr++];
+
+        record->time_us = (uint32_t)time_us;
+        record->byte = data[i];
+        record->dc = dc;
+        record->cs = cs;
+
+        if (cs != 0) {
+            // Display not selected
+            continue;
+        }
+        if (dc == 0) {
+            sim_lcd_command(data[i]);
+        } else {
+            sim_lcd_data(data[i]);
+        }
+    }
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Moves the virtual clock and the RTC and cycle counters.
+ *
+ * @param until_us  New virtual time.
+ * @param running   1 if the core runs meanwhile (cycle counter enabled).
+ */
+static void sim_update_clocks(uint64_t until_us, uint8_t running) {
+    if (until_us <= time_us) {
+        return;
+    }
+
+    if (running != 0 && (sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0) {
+        sim_dwt.CYCCNT += (uint32_t)((until_us - time_us) * core_mhz);
+    }
+
+    time_us = until_us;
+
+    uint32_t rtc = (uint32_t)(time_us * SIM_RTC_HZ / 1000000);
+    sim_rtc.CNTH = rtc >> 16;
+    sim_rtc.CNTL = rtc & 0xFFFF;
+    sim_rtc.DIVL = SIM_LSE_HZ / SIM_RTC_HZ - 1 - (uint32_t)((time_us * SIM_LSE_HZ / 1000000) % (SIM_LSE_HZ / SIM_RTC_HZ));
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Moves the virtual clock, raising the timer interrupts on the way.
+ *
+ * @param until_us  New virtual time.
+ */
+static void sim_run_until(uint64_t until_us) {
+    while (tim != NULL && tim_next_us <= until_us) {
+        sim_update_clocks(tim_next_us, 1);
+        tim_next_us += tim_period_us;
+        HAL_TIM_IRQHandler(tim);
+    }
+
+    sim_update_clocks(until_us, 1);
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Moves the virtual clock with the core sleeping.
+ *
+ * @param until_us  New virtual time.
+ */
+static void sim_idle_until(uint64_t until_us) {
+    sim_update_clocks(until_us, 0);
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Runs the key EXTI interrupt if it's enabled and a line is pending.
+ */
+static void sim_exti_raise(void) {
+    if ((nvic_enabled & (1ULL << EXTI15_10_IRQn)) == 0 || exti_pending == 0) {
+        return;
+    }
+
+    exti_wake = 1;
+    for (uint8_t line = 10; line <= 15; line++) {
+        HAL_GPIO_EXTI_IRQHandler(1 << line);
+    }
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @ingroup sim_hal
+ * @brief Resets the virtual clock, pins, display and SPI record.
+ *
+ * All keys are released (pulled up).
+ */
+void sim_reset(void) {
+    time_us = 0;
+    tim = NULL;
+    core_mhz = SIM_CORE_CLOCK_HZ / 1000000;
+    nvic_enabled = 0;
+    exti_falling = 0;
+    exti_rising = 0;
+    exti_pending = 0;
+    sim_dwt.CYCCNT = 0;
+    sim_rtc.CNTH = 0;
+    sim_rtc.CNTL = 0;
+    sim_gpioa.IDR = 0;
+    sim_gpioa.ODR = 0;
+    sim_gpiob.IDR = 0xFFFF;
+    sim_gpiob.ODR = 0;
+    sim_lcd_reset();
+    sim_spi_clear_records();
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Advances the virtual clock.
+ *
+ * @param us    Microseconds to advance.
+ */
+void sim_advance_us(uint32_t us) {
+    sim_run_until(time_us + us);
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Gets the virtual clock.
+ *
+ * @return Microseconds since the last @ref sim_reset.
+ */
+uint32_t sim_time_us(void) {
+    return (uint32_t)time_us;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Sets the pressed keys.
+ *
+ * Edges on the pins set up as EXTI inputs on that edge raise the
+ * interrupt.
+ *
+ * @param pins  GPIOB pins of the keys held down. Keys are active low.
+ */
+void sim_set_keys(uint16_t pins) {
+    uint16_t previous = sim_gpiob.IDR;
+
+    sim_gpiob.IDR = 0xFFFF & ~pins;
+    exti_pending |= previous & ~sim_gpiob.IDR & exti_falling;
+    exti_pending |= ~previous & sim_gpiob.IDR & exti_rising;
+    sim_exti_raise();
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Called on each Sleep and Stop mode step, after the clock moved.
+ *
+ * Override it to press keys while the core sleeps or the MCU is stopped.
+ *
+ * @return Non zero to leave Stop mode without a key (end of the run).
+ */
+__weak int sim_stop_hook(void) {
+    return 1;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Gets the number of recorded SPI bytes.
+ */
+size_t sim_spi_record_count(void) {
+    return spi_record_nr;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Gets the recorded SPI bytes.
+ */
+const sim_spi_record_t* sim_spi_records(void) {
+    return spi_records;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Drops the recorded SPI bytes.
+ */
+void sim_spi_clear_records(void) {
+    spi_record_nr = 0;
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Gets a pixel as shown by the display.
+ *
+ * @param x     Column (from 0 to 83).
+ * @param y     Row (from 0 to 47).
+ *
+ * @return 1 if the pixel is dark, 0 otherwise.
+ */
+uint8_t sim_lcd_pixel(uint8_t x, uint8_t y) {
+    uint8_t pixel = (lcd.ram[(y / 8) * SIM_LCD_WIDTH + x] >> (y % 8)) & 1;
+
+    if (lcd.function & SIM_CMD_FUNC_PD) {
+        return 0;
+    }
+
+    switch (lcd.display) {
+        case SIM_CMD_DISPLAY_D:
+            return pixel;
+        case SIM_CMD_DISPLAY_D | SIM_CMD_DISPLAY_E:
+            return pixel ^ 1;
+        case SIM_CMD_DISPLAY_E:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Writes the display image as a binary PBM file.
+ *
+ * @param path  Output file.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sim_lcd_write_pbm(const char* path) {
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "P4\n%d %d\n", SIM_LCD_WIDTH, SIM_LCD_HEIGHT);
+    for (uint8_t y = 0; y < SIM_LCD_HEIGHT; y++) {
+        uint8_t row[(SIM_LCD_WIDTH + 7) / 8] = { 0 };
+
+        for (uint8_t x = 0; x < SIM_LCD_WIDTH; x++) {
+            row[x / 8] |= sim_lcd_pixel(x, y) << (7 - (x % 8));
+        }
+        fwrite(row, sizeof(row), 1, file);
+    }
+
+    return fclose(file);
+}
+
+/**
+ * @ingroup sim_hal
+ * @brief Writes the display image as a binary PGM file.
+ *
+ * Dark pixels are drawn over the greenish gray of the panel backlight.
+ *
+ * @param path  Output file.
+ * @param scale Size of each display pixel in the image (1 or more).
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sim_lcd_write_pgm(const char* path, uint8_t scale) {
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return -1;
+    }
+    if (scale == 0) {
+        scale = 1;
+    }
+
+    fprintf(file, "P5\n%d %d\n255\n", SIM_LCD_WIDTH * scale, SIM_LCD_HEIGHT * scale);
+    for (uint16_t y = 0; y < SIM_LCD_HEIGHT * scale; y++) {
+        for (uint16_t x = 0; x < SIM_LCD_WIDTH * scale; x++) {
+            fputc(sim_lcd_pixel(x / scale, y / scale) ? 0x20 : 0xB0, file);
+        }
+    }
+
+    return fclose(file);
+}
+
+/* HAL stand-in --------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_Init(void) {
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+    sim_update_clocks(time_us + SIM_POLL_COST_US, 1);
+    return (uint32_t)(time_us / 1000);
+}
+
+void HAL_SuspendTick(void) {
+}
+
+void HAL_ResumeTick(void) {
+}
+
+void HAL_Delay(uint32_t delay) {
+    sim_run_until(time_us + (uint64_t)delay * 1000);
+}
+
+void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef* init, uint32_t* flash_latency) {
+    memset(init, 0, sizeof(*init));
+    init->SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+    init->APB1CLKDivider = RCC_HCLK_DIV2;
+    init->APB2CLKDivider = RCC_HCLK_DIV2;
+    *flash_latency = 2;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return SIM_PCLK1_HZ;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+    return SIM_PCLK2_HZ;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* init) {
+    if (init->PLL.PLLState == RCC_PLL_ON) {
+        sim_run_until(time_us + SIM_PLL_START_US);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* init, uint32_t flash_latency) {
+    (void)flash_latency;
+    if (init->SYSCLKSource == RCC_SYSCLKSOURCE_PLLCLK) {
+        core_mhz = SIM_CORE_CLOCK_HZ / 1000000;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init) {
+    (void)init;
+    return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void) {
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t regulator, uint8_t entry) {
+    (void)regulator;
+    (void)entry;
+
+    exti_wake = 0;
+    while (tim != NULL) {
+        if (tim_next_us <= time_us + SIM_STOP_STEP_US) {
+            sim_idle_until(tim_next_us);
+            sim_run_until(time_us);
+            break;
+        }
+
+        sim_idle_until(time_us + SIM_STOP_STEP_US);
+        if (sim_stop_hook() != 0 || exti_wake != 0) {
+            break;
+        }
+    }
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t regulator, uint8_t entry) {
+    (void)regulator;
+    (void)entry;
+
+    exti_wake = 0;
+    while (exti_wake == 0) {
+        // Timers are frozen
+        sim_idle_until(time_us + SIM_STOP_STEP_US);
+        tim_next_us += SIM_STOP_STEP_US;
+
+        if (sim_stop_hook() != 0) {
+            break;
+        }
+    }
+
+    // Wakes up on HSI
+    core_mhz = HSI_VALUE / 1000000;
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef* hrtc) {
+    (void)hrtc;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_WaitForSynchro(RTC_HandleTypeDef* hrtc) {
+    (void)hrtc;
+    return HAL_OK;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority) {
+    (void)irq;
+    (void)preempt_priority;
+    (void)sub_priority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) {
+    nvic_enabled |= 1ULL << irq;
+    sim_exti_raise();
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type irq) {
+    nvic_enabled &= ~(1ULL << irq);
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    (void)irq;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* gpio, GPIO_InitTypeDef* init) {
+    if (gpio != GPIOB) {
+        return;
+    }
+
+    if (init->Mode == GPIO_MODE_IT_FALLING || init->Mode == GPIO_MODE_IT_RISING_FALLING) {
+        exti_falling |= init->Pin;
+    }
+    if (init->Mode == GPIO_MODE_IT_RISING_FALLING) {
+        exti_rising |= init->Pin;
+    }
+}
+
+void sim_exti_clear(uint16_t pins) {
+    exti_pending &= ~pins;
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin) {
+    if (exti_pending & pin) {
+        exti_pending &= ~pin;
+        HAL_GPIO_EXTI_Callback(pin);
+    }
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t pin) {
+    (void)pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* gpio, uint16_t pin) {
+    return (gpio->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* gpio, uint16_t pin, GPIO_PinState state) {
+    uint32_t previous = gpio->ODR;
+
+    if (state == GPIO_PIN_SET) {
+        gpio->ODR |= pin;
+    } else {
+        gpio->ODR &= ~pin;
+    }
+
+    // Display reset on the RST falling edge
+    if (gpio == SIM_LCD_PORT && (previous & SIM_LCD_RST_PIN) && !(gpio->ODR & SIM_LCD_RST_PIN)) {
+        sim_lcd_reset();
+    }
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma) {
+    (void)hdma;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef* hdma) {
+    (void)hdma;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi) {
+    (void)hspi;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size, uint32_t timeout) {
+    (void)hspi;
+    (void)timeout;
+    sim_spi_shift(data, size);
+    return HAL_OK;
+}
+
+// MISO is wired to MOSI, the bytes come back as sent
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* tx_data, uint8_t* rx_data, uint16_t size, uint32_t timeout) {
+    (void)hspi;
+    (void)timeout;
+    sim_spi_shift(tx_data, size);
+    memcpy(rx_data, tx_data, size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size) {
+    sim_spi_shift(data, size);
+    HAL_SPI_TxCpltCallback(hspi);
+    return HAL_OK;
+}
+
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi) {
+    (void)hspi;
+}
+
+__weak void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi) {
+    (void)hspi;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim) {
+    (void)htim;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) {
+    tim = htim;
+    tim_period_us = ((uint64_t)htim->Init.Prescaler + 1) * (htim->Init.Period + 1) / SIM_TIM_CLOCK_MHZ;
+    if (tim_period_us == 0) {
+        tim_period_us = 1;
+    }
+    tim_next_us = time_us + tim_period_us;
+    return HAL_OK;
+}
+
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef* htim) {
+    uint64_t elapsed_us = time_us - (tim_next_us - tim_period_us);
+
+    return (uint32_t)(elapsed_us * SIM_TIM_CLOCK_MHZ / (htim->Init.Prescaler + 1));
+}
+
+void sim_tim_set_counter(TIM_HandleTypeDef* htim, uint32_t counter) {
+    uint64_t elapsed_us = (uint64_t)counter * (htim->Init.Prescaler + 1) / SIM_TIM_CLOCK_MHZ;
+
+    tim_period_us = ((uint64_t)htim->Init.Prescaler + 1) * (htim->Init.Period + 1) / SIM_TIM_CLOCK_MHZ;
+    tim_next_us = time_us - elapsed_us + tim_period_us;
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim) {
+    HAL_TIM_PeriodElapsedCallback(htim);
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim) {
+    (void)htim;
+}
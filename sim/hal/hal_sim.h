@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @ingroup sim_hal
+ * @brief Host simulator control interface.
+ *
+ * Drives the virtual clock and keyboard, and gives access to the
+ * recorded SPI traffic and to the emulated PCD8544 display RAM.
+ */
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_LCD_WIDTH   84
+#define SIM_LCD_HEIGHT  48
+
+/**
+ * @ingroup sim_hal
+ * @brief One byte shifted out on the display SPI bus.
+ */
+typedef struct {
+    uint32_t time_us;   /**< Virtual time of the transfer. */
+    uint8_t byte;       /**< Byte sent. */
+    uint8_t dc;         /**< DC pin level (0 = command, 1 = data). */
+    uint8_t cs;         /**< CS pin level (0 = display selected). */
+} sim_spi_record_t;
+
+void sim_reset(void);
+void sim_advance_us(uint32_t us);
+uint32_t sim_time_us(void);
+void sim_set_keys(uint16_t pins);
+int sim_stop_hook(void);
+
+size_t sim_spi_record_count(void);
+const sim_spi_record_t* sim_spi_records(void);
+void sim_spi_clear_records(void);
+
+uint8_t sim_lcd_pixel(uint8_t x, uint8_t y);
+int sim_lcd_write_pbm(const char* path);
+int sim_lcd_write_pgm(const char* path, uint8_t scale);
+
+#endif /* HAL_SIM_H */
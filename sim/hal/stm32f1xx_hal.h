@@ -0,0 +1,345 @@
+/**
+ * @file
+ * @defgroup sim_hal Host HAL stand-in
+ * @brief Minimal STM32F1 HAL stand-in for the host simulator.
+ *
+ * Declares only the HAL types, macros and functions used by the game
+ * and the display driver, so they build unmodified on a workstation.
+ * The implementation in hal_sim.c models the display and the keyboard.
+ */
+#ifndef STM32F1XX_HAL_H
+#define STM32F1XX_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __weak  __attribute__((weak))
+
+/* HAL ----------------------------------------------------------------------*/
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT,
+} HAL_StatusTypeDef;
+
+HAL_StatusTypeDef HAL_Init(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+/* Core ---------------------------------------------------------------------*/
+// Interrupts are only raised by the simulator when the clock moves
+#define __disable_irq()
+#define __enable_irq()
+#define __DMB()
+
+#define HSI_VALUE   8000000U
+
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_core_debug;
+
+#define DWT         (&sim_dwt)
+#define CoreDebug   (&sim_core_debug)
+
+#define DWT_CTRL_CYCCNTENA_Msk          0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk      0x01000000U
+
+/* NVIC ---------------------------------------------------------------------*/
+typedef enum {
+    DMA1_Channel3_IRQn = 13,
+    TIM2_IRQn = 28,
+    EXTI15_10_IRQn = 40,
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void HAL_NVIC_DisableIRQ(IRQn_Type irq);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type irq);
+
+/* RCC ----------------------------------------------------------------------*/
+#define __HAL_RCC_GPIOA_CLK_ENABLE()
+#define __HAL_RCC_GPIOB_CLK_ENABLE()
+#define __HAL_RCC_SPI1_CLK_ENABLE()
+#define __HAL_RCC_DMA1_CLK_ENABLE()
+#define __HAL_RCC_TIM2_CLK_ENABLE()
+#define __HAL_RCC_PWR_CLK_ENABLE()
+#define __HAL_RCC_BKP_CLK_ENABLE()
+#define __HAL_RCC_RTC_ENABLE()
+
+typedef struct {
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLMUL;
+} RCC_PLLInitTypeDef;
+
+typedef struct {
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    uint32_t HSEPredivValue;
+    uint32_t LSEState;
+    uint32_t HSIState;
+    uint32_t LSIState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct {
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct {
+    uint32_t PeriphClockSelection;
+    uint32_t RTCClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSE      0x01
+#define RCC_OSCILLATORTYPE_LSE      0x04
+#define RCC_HSE_ON                  0x01
+#define RCC_LSE_ON                  0x01
+#define RCC_PLL_NONE                0x00
+#define RCC_PLL_ON                  0x02
+#define RCC_CLOCKTYPE_SYSCLK        0x01
+#define RCC_SYSCLKSOURCE_PLLCLK     0x02
+#define RCC_HCLK_DIV1               0x0000
+#define RCC_HCLK_DIV2               0x0400
+#define RCC_PERIPHCLK_RTC           0x01
+#define RCC_RTCCLKSOURCE_LSE        0x100
+
+#define FLASH_LATENCY_2             0x02
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* init);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* init, uint32_t flash_latency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init);
+void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef* init, uint32_t* flash_latency);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+/* PWR ----------------------------------------------------------------------*/
+#define PWR_MAINREGULATOR_ON        0x00
+#define PWR_LOWPOWERREGULATOR_ON    0x01
+#define PWR_SLEEPENTRY_WFI          0x01
+#define PWR_STOPENTRY_WFI           0x01
+
+void HAL_PWR_EnableBkUpAccess(void);
+void HAL_PWR_EnterSLEEPMode(uint32_t regulator, uint8_t entry);
+void HAL_PWR_EnterSTOPMode(uint32_t regulator, uint8_t entry);
+
+/* GPIO ---------------------------------------------------------------------*/
+typedef struct {
+    volatile uint32_t IDR;
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpioa;
+extern GPIO_TypeDef sim_gpiob;
+
+#define GPIOA   (&sim_gpioa)
+#define GPIOB   (&sim_gpiob)
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET,
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0      ((uint16_t)0x0001)
+#define GPIO_PIN_1      ((uint16_t)0x0002)
+#define GPIO_PIN_4      ((uint16_t)0x0010)
+#define GPIO_PIN_5      ((uint16_t)0x0020)
+#define GPIO_PIN_6      ((uint16_t)0x0040)
+#define GPIO_PIN_7      ((uint16_t)0x0080)
+#define GPIO_PIN_12     ((uint16_t)0x1000)
+#define GPIO_PIN_13     ((uint16_t)0x2000)
+#define GPIO_PIN_14     ((uint16_t)0x4000)
+#define GPIO_PIN_15     ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT         0x00
+#define GPIO_MODE_OUTPUT_PP     0x01
+#define GPIO_MODE_AF_PP         0x02
+#define GPIO_MODE_AF_INPUT      GPIO_MODE_INPUT
+#define GPIO_MODE_IT_FALLING    0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+
+#define GPIO_NOPULL     0x00
+#define GPIO_PULLUP     0x01
+
+#define GPIO_SPEED_FREQ_HIGH    0x03
+
+void HAL_GPIO_Init(GPIO_TypeDef* gpio, GPIO_InitTypeDef* init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* gpio, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef* gpio, uint16_t pin, GPIO_PinState state);
+
+/* EXTI ---------------------------------------------------------------------*/
+#define __HAL_GPIO_EXTI_CLEAR_IT(pins)  sim_exti_clear(pins)
+
+void sim_exti_clear(uint16_t pins);
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin);
+void HAL_GPIO_EXTI_Callback(uint16_t pin);
+
+/* DMA ----------------------------------------------------------------------*/
+typedef struct {
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct {
+    void* Instance;
+    DMA_InitTypeDef Init;
+    void* Parent;
+} DMA_HandleTypeDef;
+
+#define DMA1_Channel3   ((void*)0x40020030)
+
+#define DMA_MEMORY_TO_PERIPH    0x10
+#define DMA_PINC_DISABLE        0x00
+#define DMA_MINC_ENABLE         0x80
+#define DMA_PDATAALIGN_BYTE     0x00
+#define DMA_MDATAALIGN_BYTE     0x00
+#define DMA_NORMAL              0x00
+#define DMA_PRIORITY_LOW        0x00
+
+#define __HAL_LINKDMA(handle, field, dma)   \
+    do {                                    \
+        (handle)->field = &(dma);           \
+        (dma).Parent = (handle);            \
+    } while (0)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef* hdma);
+
+/* SPI ----------------------------------------------------------------------*/
+typedef struct {
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t NSS;
+    uint32_t BaudRatePrescaler;
+    uint32_t FirstBit;
+    uint32_t TIMode;
+    uint32_t CRCCalculation;
+} SPI_InitTypeDef;
+
+typedef struct {
+    void* Instance;
+    SPI_InitTypeDef Init;
+    DMA_HandleTypeDef* hdmatx;
+} SPI_HandleTypeDef;
+
+#define SPI1    ((void*)0x40013000)
+
+#define SPI_MODE_MASTER             0x0104
+#define SPI_DIRECTION_2LINES        0x0000
+#define SPI_DATASIZE_8BIT           0x0000
+#define SPI_POLARITY_LOW            0x0000
+#define SPI_PHASE_1EDGE             0x0000
+#define SPI_NSS_SOFT                0x0200
+#define SPI_BAUDRATEPRESCALER_2     0x0000
+#define SPI_BAUDRATEPRESCALER_4     0x0008
+#define SPI_BAUDRATEPRESCALER_8     0x0010
+#define SPI_BAUDRATEPRESCALER_16    0x0018
+#define SPI_BAUDRATEPRESCALER_32    0x0020
+#define SPI_BAUDRATEPRESCALER_64    0x0028
+#define SPI_BAUDRATEPRESCALER_128   0x0030
+#define SPI_BAUDRATEPRESCALER_256   0x0038
+#define SPI_FIRSTBIT_MSB            0x0000
+#define SPI_TIMODE_DISABLE          0x0000
+#define SPI_CRCCALCULATION_DISABLE  0x0000
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* tx_data, uint8_t* rx_data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi);
+
+/* TIM ----------------------------------------------------------------------*/
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    void* Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+#define TIM2    ((void*)0x40000000)
+
+#define TIM_COUNTERMODE_UP              0x0000
+#define TIM_CLOCKDIVISION_DIV1          0x0000
+#define TIM_AUTORELOAD_PRELOAD_DISABLE  0x0000
+
+#define __HAL_TIM_GET_COUNTER(handle)           sim_tim_get_counter(handle)
+#define __HAL_TIM_SET_COUNTER(handle, counter)  sim_tim_set_counter(handle, counter)
+#define __HAL_TIM_SET_AUTORELOAD(handle, arr)   ((handle)->Init.Period = (arr))
+
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef* htim);
+void sim_tim_set_counter(TIM_HandleTypeDef* htim, uint32_t counter);
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim);
+
+/* RTC ----------------------------------------------------------------------*/
+typedef struct {
+    volatile uint32_t DIVH;
+    volatile uint32_t DIVL;
+    volatile uint32_t CNTH;
+    volatile uint32_t CNTL;
+} RTC_TypeDef;
+
+typedef struct {
+    uint32_t AsynchPrediv;
+    uint32_t OutPut;
+} RTC_InitTypeDef;
+
+typedef struct {
+    RTC_TypeDef* Instance;
+    RTC_InitTypeDef Init;
+} RTC_HandleTypeDef;
+
+extern RTC_TypeDef sim_rtc;
+
+#define RTC     (&sim_rtc)
+
+#define RTC_OUTPUTSOURCE_NONE   0x00
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef* hrtc);
+HAL_StatusTypeDef HAL_RTC_WaitForSynchro(RTC_HandleTypeDef* hrtc);
+
+#endif /* STM32F1XX_HAL_H */
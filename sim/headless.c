@@ -0,0 +1,379 @@
+/**
+ * @file
+ * @brief Headless game runner.
+ *
+ * Plays many games with no display nor timing, as fast as the host
+ * allows, spread over several threads. Each game has its own context and
+ * seed, and its keys come from an input policy instead of the keyboard.
+ * Prints the step rate and the score distribution.
+ *
+ * Usage: snake_headless [-g games] [-j threads] [-s seed] [-m max_steps]
+ *                       [-p random|greedy|auto]
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "snake.h"
+#include "prng.h"
+#include "autopilot.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Private types -------------------------------------------------------------*/
+/**
+ * @brief Input policy data, one per game.
+ */
+typedef struct {
+    prng_t prng;        /**< Policy generator. */
+    uint32_t step;      /**< Last step a key was given at. */
+} headless_policy_t;
+
+/**
+ * @brief Result of a game.
+ */
+typedef struct {
+    uint32_t steps;     /**< Steps played. */
+    snake_cell_t score; /**< Final snake size. */
+    uint8_t state;      /**< Final state, playing if stopped at max_steps. */
+} headless_result_t;
+
+/**
+ * @brief Games run by a thread.
+ */
+typedef struct {
+    pthread_t thread;
+    uint32_t first;             /**< First game. */
+    uint32_t stride;            /**< Games between two games of the thread. */
+} headless_worker_t;
+
+/* Private defines -----------------------------------------------------------*/
+#define HEADLESS_MAX_THREADS    64
+#define HEADLESS_HISTOGRAM_BIN  10
+
+// Chance of a random turn at each step, in 1/256
+#define HEADLESS_TURN_CHANCE    32
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t game_nr = 10000;
+static uint32_t thread_nr = 0;
+static uint32_t base_seed = 1;
+static uint32_t max_steps = 100000;
+static snake_input_t policy = NULL;
+
+static headless_result_t* results = NULL;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t headless_now_ns(void);
+static snake_pos_t headless_next_cell(snake_pos_t pos, snake_dir_t direction);
+static uint8_t headless_is_free(const snake_game_t* game, snake_pos_t pos);
+static uint8_t headless_random(snake_game_t* game, keyboard_key_t* key);
+static uint8_t headless_greedy(snake_game_t* game, keyboard_key_t* key);
+static void headless_play(uint32_t index);
+static void* headless_worker(void* arg);
+static int headless_compare(const void* a, const void* b);
+static void headless_report(double seconds);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @brief Reads the monotonic clock.
+ */
+static uint64_t headless_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * @brief Gets the neighbour cell, wrapping around the board edges.
+ */
+static snake_pos_t headless_next_cell(snake_pos_t pos, snake_dir_t direction) {
+    switch (direction) {
+        case SNAKE_DIR_RIGHT:
+            pos.x = (pos.x + 1 == SNAKE_MAX_X) ? 0 : pos.x + 1;
+        break;
+        case SNAKE_DIR_DOWN:
+            pos.y = (pos.y + 1 == SNAKE_MAX_Y) ? 0 : pos.y + 1;
+        break;
+        case SNAKE_DIR_LEFT:
+            pos.x = (pos.x == 0) ? SNAKE_MAX_X - 1 : pos.x - 1;
+        break;
+        case SNAKE_DIR_UP:
+            pos.y = (pos.y == 0) ? SNAKE_MAX_Y - 1 : pos.y - 1;
+        break;
+        default:
+        break;
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Checks if a cell isn't covered by the snake.
+ */
+static uint8_t headless_is_free(const snake_game_t* game, snake_pos_t pos) {
+    uint16_t cell = SNAKE_CELL(pos.x, pos.y);
+
+    return (game->free_slot[cell] < game->free_cell_nr);
+}
+
+/**
+ * @brief Random policy: turns left or right once in a while.
+ */
+static uint8_t headless_random(snake_game_t* game, keyboard_key_t* key) {
+    headless_policy_t* data = game->input_context;
+
+    if (key == NULL || data->step == game->step) {
+        return 0;
+    }
+    data->step = game->step;
+
+    uint32_t draw = prng_next(&data->prng);
+    if ((draw & 0xFF) >= HEADLESS_TURN_CHANCE) {
+        return 0;
+    }
+
+    // Directions and keys share the same order
+    *key = (game->direction + ((draw & 0x100) ? 1 : 3)) & 3;
+    return 1;
+}
+
+/**
+ * @brief Greedy policy: heads for the food the short way around the
+ * board, avoiding the cells covered by the snake when it can.
+ */
+static uint8_t headless_greedy(snake_game_t* game, keyboard_key_t* key) {
+    headless_policy_t* data = game->input_context;
+
+    if (key == NULL || data->step == game->step) {
+        return 0;
+    }
+    data->step = game->step;
+
+    snake_pos_t head = { .x = SNAKE_CELL_X(game->snake[game->head]), .y = SNAKE_CELL_Y(game->snake[game->head]) };
+    int8_t dx = game->food.x - head.x;
+    int8_t dy = game->food.y - head.y;
+
+    if (2 * dx > SNAKE_MAX_X) {
+        dx -= SNAKE_MAX_X;
+    } else if (2 * dx < -SNAKE_MAX_X) {
+        dx += SNAKE_MAX_X;
+    }
+    if (2 * dy > SNAKE_MAX_Y) {
+        dy -= SNAKE_MAX_Y;
+    } else if (2 * dy < -SNAKE_MAX_Y) {
+        dy += SNAKE_MAX_Y;
+    }
+
+    // Preferred directions first, then the current one, then any other
+    snake_dir_t order[6];
+    uint8_t order_nr = 0;
+
+    if (dx != 0) {
+        order[order_nr++] = (dx > 0) ? SNAKE_DIR_RIGHT : SNAKE_DIR_LEFT;
+    }
+    if (dy != 0) {
+        order[order_nr++] = (dy > 0) ? SNAKE_DIR_DOWN : SNAKE_DIR_UP;
+    }
+    order[order_nr++] = game->direction;
+    order[order_nr++] = (game->direction + 1) & 3;
+    order[order_nr++] = (game->direction + 3) & 3;
+
+    for (uint8_t i = 0; i < order_nr; i++) {
+        // No turning back
+        if (order[i] == ((game->direction + 2) & 3)) {
+            continue;
+        }
+
+        snake_pos_t next = headless_next_cell(head, order[i]);
+        if (headless_is_free(game, next) == 0) {
+            continue;
+        }
+
+        if (order[i] == game->direction) {
+            return 0;
+        }
+
+        *key = (keyboard_key_t)order[i];
+        return 1;
+    }
+
+    // Trapped
+    return 0;
+}
+
+/**
+ * @brief Plays a game until it ends or max_steps.
+ *
+ * @param index Game index, also the seed offset.
+ */
+static void headless_play(uint32_t index) {
+    snake_game_t game = { 0 };
+    headless_policy_t data = { 0 };
+    autopilot_t pilot;
+
+    prng_seed(&data.prng, ~(base_seed + index));
+    data.step = UINT32_MAX;
+    autopilot_init(&pilot);
+
+    game.headless = 1;
+    game.input_context = (policy == autopilot_input) ? (void*)&pilot : (void*)&data;
+    snake_seed(&game, base_seed + index);
+    snake_init(&game);
+
+    while (game.state == SNAKE_STATE_PLAYING && game.step < max_steps) {
+        snake_step(&game, policy);
+    }
+
+    results[index].steps = game.step;
+    results[index].score = game.size;
+    results[index].state = game.state;
+}
+
+/**
+ * @brief Plays every stride-th game from the first one.
+ */
+static void* headless_worker(void* arg) {
+    headless_worker_t* worker = arg;
+
+    for (uint32_t i = worker->first; i < game_nr; i += worker->stride) {
+        headless_play(i);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Orders results by score.
+ */
+static int headless_compare(const void* a, const void* b) {
+    const headless_result_t* ra = a;
+    const headless_result_t* rb = b;
+
+    return (int)ra->score - (int)rb->score;
+}
+
+/**
+ * @brief Prints the step rate and the score distribution.
+ *
+ * @param seconds   Wall time of all games.
+ */
+static void headless_report(double seconds) {
+    uint64_t total_steps = 0;
+    uint64_t total_score = 0;
+    uint32_t wins = 0;
+    uint32_t timeouts = 0;
+    uint32_t histogram[SNAKE_CELLS / HEADLESS_HISTOGRAM_BIN + 1] = { 0 };
+
+    for (uint32_t i = 0; i < game_nr; i++) {
+        total_steps += results[i].steps;
+        total_score += results[i].score;
+        histogram[results[i].score / HEADLESS_HISTOGRAM_BIN]++;
+        if (results[i].state == SNAKE_STATE_WIN) {
+            wins++;
+        } else if (results[i].state == SNAKE_STATE_PLAYING) {
+            timeouts++;
+        }
+    }
+
+    qsort(results, game_nr, sizeof(results[0]), headless_compare);
+
+    printf("%u games, %u threads, %.3f s\n", game_nr, thread_nr, seconds);
+    printf("  %llu steps, %.1f M steps/s, %.0f games/s\n",
+           (unsigned long long)total_steps, total_steps / seconds / 1e6, game_nr / seconds);
+    printf("  %u won, %u stopped at %u steps\n", wins, timeouts, max_steps);
+    printf("score: min %u, mean %.1f, max %u\n",
+           results[0].score, (double)total_score / game_nr, results[game_nr - 1].score);
+    printf("  p10 %u, p50 %u, p90 %u, p99 %u\n",
+           results[game_nr / 10].score, results[game_nr / 2].score,
+           results[game_nr * 9 / 10].score, results[game_nr * 99 / 100].score);
+
+    for (uint16_t i = 0; i < sizeof(histogram) / sizeof(histogram[0]); i++) {
+        if (histogram[i] == 0) {
+            continue;
+        }
+
+        uint32_t bar = (uint64_t)histogram[i] * 50 / game_nr;
+        printf("  %3u-%-3u %8u ", i * HEADLESS_HISTOGRAM_BIN, i * HEADLESS_HISTOGRAM_BIN + HEADLESS_HISTOGRAM_BIN - 1, histogram[i]);
+        for (uint32_t j = 0; j < bar; j++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+/* Public functions ----------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    headless_worker_t workers[HEADLESS_MAX_THREADS];
+    int option;
+
+    policy = headless_greedy;
+    while ((option = getopt(argc, argv, "g:j:s:m:p:")) != -1) {
+        switch (option) {
+            case 'g':
+                game_nr = strtoul(optarg, NULL, 0);
+            break;
+            case 'j':
+                thread_nr = strtoul(optarg, NULL, 0);
+            break;
+            case 's':
+                base_seed = strtoul(optarg, NULL, 0);
+            break;
+            case 'm':
+                max_steps = strtoul(optarg, NULL, 0);
+            break;
+            case 'p':
+                if (strcmp(optarg, "random") == 0) {
+                    policy = headless_random;
+                } else if (strcmp(optarg, "greedy") == 0) {
+                    policy = headless_greedy;
+                } else if (strcmp(optarg, "auto") == 0) {
+                    policy = autopilot_input;
+                } else {
+                    fprintf(stderr, "unknown policy %s\n", optarg);
+                    return 1;
+                }
+            break;
+            default:
+                fprintf(stderr, "usage: %s [-g games] [-j threads] [-s seed] [-m max_steps] [-p random|greedy|auto]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (thread_nr == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_nr = (cpus > 0) ? cpus : 1;
+    }
+    if (thread_nr > HEADLESS_MAX_THREADS) {
+        thread_nr = HEADLESS_MAX_THREADS;
+    }
+    if (game_nr == 0) {
+        return 0;
+    }
+
+    results = calloc(game_nr, sizeof(results[0]));
+    if (results == NULL) {
+        perror("calloc");
+        return 1;
+    }
+
+    uint64_t start = headless_now_ns();
+
+    for (uint32_t i = 0; i < thread_nr; i++) {
+        workers[i].first = i;
+        workers[i].stride = thread_nr;
+        pthread_create(&workers[i].thread, NULL, headless_worker, &workers[i]);
+    }
+    for (uint32_t i = 0; i < thread_nr; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    headless_report((headless_now_ns() - start) / 1e9);
+
+    free(results);
+    return 0;
+}
@@ -0,0 +1,441 @@
+/**
+ * @file
+ * @brief Host simulator main file.
+ *
+ * Runs the game against the HAL stand-in, with key presses read from
+ * a script or generated at random, or played by the autopilot, and
+ * dumps the display image after each screen update.
+ *
+ * Input script: one event per line, "<time ms> <keys>", where keys is
+ * any combination of R, D, L and U held from that time on, or "-" to
+ * release all keys. Lines starting with '#' are ignored.
+ *
+ * The game inputs are recorded (see @ref replay) and the last game can
+ * be written to a file, to be played again with the same screen updates.
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "snake.h"
+#include "nokia5110.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "power.h"
+#include "keyboard.h"
+#include "replay.h"
+#include "autopilot.h"
+
+#include "stm32f1xx_hal.h"
+#include "hal_sim.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private types -------------------------------------------------------------*/
+/**
+ * @brief Scripted key event.
+ */
+typedef struct {
+    uint32_t time_ms;   /**< Time the keys change. */
+    uint16_t keys;      /**< GPIOB pins held down from then on. */
+} sim_key_event_t;
+
+/* Private defines -----------------------------------------------------------*/
+#define SIM_DEFAULT_RUN_MS  10000
+#define SIM_MAX_EVENTS      4096
+
+// Random input: a press of SIM_RANDOM_HOLD_MS every SIM_RANDOM_PERIOD_MS
+#define SIM_RANDOM_PERIOD_MS    400
+#define SIM_RANDOM_HOLD_MS      30
+
+#define SIM_KEY_RIGHT   GPIO_PIN_12
+#define SIM_KEY_DOWN    GPIO_PIN_13
+#define SIM_KEY_LEFT    GPIO_PIN_14
+#define SIM_KEY_UP      GPIO_PIN_15
+
+/* Private variables ---------------------------------------------------------*/
+static sim_key_event_t events[SIM_MAX_EVENTS];
+static size_t event_nr = 0;
+static size_t next_event = 0;
+static uint32_t run_ms = SIM_DEFAULT_RUN_MS;
+
+static const char* frame_dir = NULL;
+static uint8_t frame_scale = 0;
+static uint32_t frame_nr = 0;
+static uint32_t frame_bursts = 0;
+static uint32_t frame_segments = 0;
+
+static snake_game_t game = { 0 };
+static autopilot_t pilot;
+
+/* Private function prototypes -----------------------------------------------*/
+static int sim_load_script(const char* path);
+static int sim_load_replay(const char* path);
+static int sim_write_replay(const char* path);
+static void sim_random_script(uint32_t seed, uint32_t run_ms);
+static void sim_apply_events(void);
+static void sim_clock_config(void);
+static int sim_write_trace(const char* path);
+static void sim_usage(const char* name);
+
+/* Private function implementation--------------------------------------------*/
+/**
+ * @brief Reads an input script.
+ *
+ * @param path  Script file.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sim_load_script(const char* path) {
+    FILE* file = fopen(path, "r");
+    char line[128];
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL && event_nr < SIM_MAX_EVENTS) {
+        unsigned long time_ms;
+        char keys[16];
+
+        if (line[0] == '#' || sscanf(line, "%lu %15s", &time_ms, keys) != 2) {
+            continue;
+        }
+
+        sim_key_event_t* event = &events[event_nr++];
+        event->time_ms = time_ms;
+        event->keys = 0;
+        for (char* key = keys; *key != '\0'; key++) {
+            switch (*key) {
+                case 'R': event->keys |= SIM_KEY_RIGHT; break;
+                case 'D': event->keys |= SIM_KEY_DOWN; break;
+                case 'L': event->keys |= SIM_KEY_LEFT; break;
+                case 'U': event->keys |= SIM_KEY_UP; break;
+                default: break;
+            }
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/**
+ * @brief Reads a replay log and starts playing it.
+ *
+ * @param path  Log file.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sim_load_replay(const char* path) {
+    static uint8_t log[REPLAY_LOG_SIZE + 1];
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    size_t size = fread(log, 1, sizeof(log), file);
+    fclose(file);
+
+    return (replay_play(log, size) != 0) ? 0 : -1;
+}
+
+/**
+ * @brief Writes the replay log.
+ *
+ * @param path  Log file.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sim_write_replay(const char* path) {
+    const uint8_t* log;
+    uint16_t size = replay_get_log(&log);
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    if (fwrite(log, 1, size, file) != size) {
+        fclose(file);
+        return -1;
+    }
+
+    return fclose(file);
+}
+
+/**
+ * @brief Generates random key presses for the whole run.
+ *
+ * @param seed      Generator seed.
+ * @param run_ms    Run duration.
+ */
+static void sim_random_script(uint32_t seed, uint32_t run_ms) {
+    static const uint16_t keys[] = { SIM_KEY_RIGHT, SIM_KEY_DOWN, SIM_KEY_LEFT, SIM_KEY_UP };
+    uint32_t state = seed ? seed : 1;
+
+    for (uint32_t t = SIM_RANDOM_PERIOD_MS; t < run_ms && event_nr + 2 <= SIM_MAX_EVENTS; t += SIM_RANDOM_PERIOD_MS) {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        events[event_nr].time_ms = t;
+        events[event_nr++].keys = keys[state % 4];
+        events[event_nr].time_ms = t + SIM_RANDOM_HOLD_MS;
+        events[event_nr++].keys = 0;
+    }
+}
+
+/**
+ * @brief Applies the key events due at the current virtual time.
+ */
+static void sim_apply_events(void) {
+    uint32_t now_ms = sim_time_us() / 1000;
+
+    while (next_event < event_nr && events[next_event].time_ms <= now_ms) {
+        sim_set_keys(events[next_event++].keys);
+    }
+}
+
+/**
+ * @brief Restores the PLL after a Stop mode wake up, as clock_config does.
+ */
+static void sim_clock_config(void) {
+    RCC_OscInitTypeDef osc_init = { 0 };
+    RCC_ClkInitTypeDef clk_init = { 0 };
+
+    osc_init.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+    osc_init.HSEState = RCC_HSE_ON;
+    osc_init.PLL.PLLState = RCC_PLL_ON;
+    HAL_RCC_OscConfig(&osc_init);
+
+    clk_init.ClockType = RCC_CLOCKTYPE_SYSCLK;
+    clk_init.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+    HAL_RCC_ClockConfig(&clk_init, FLASH_LATENCY_2);
+}
+
+/**
+ * @brief Writes the recorded SPI traffic as text.
+ *
+ * One byte per line: time (us), DC, CS and the byte in hex.
+ *
+ * @param path  Output file.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sim_write_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    const sim_spi_record_t* records = sim_spi_records();
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "# time_us dc cs byte\n");
+    for (size_t i = 0; i < sim_spi_record_count(); i++) {
+        fprintf(file, "%u %u %u %02X\n", records[i].time_us, records[i].dc, records[i].cs, records[i].byte);
+    }
+
+    return fclose(file);
+}
+
+/**
+ * @brief Prints the command line help.
+ *
+ * @param name  Program name.
+ */
+static void sim_usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [-n run_ms] [-i script | -r seed | -a] [-s seed | -l replay] [-w replay]\n"
+            "          [-o frame_dir [-p scale]] [-t trace]\n"
+            "  -n  simulated time in ms (default %d)\n"
+            "  -i  key input script\n"
+            "  -r  random key presses with the given seed\n"
+            "  -s  food placement seed (default %d)\n"
+            "  -l  play a replay log (seed and keys)\n"
+            "  -w  write the replay log of the last game\n"
+            "  -a  let the autopilot play, restarting at once after each game\n"
+            "  -o  dump each screen update as a PBM frame in frame_dir\n"
+            "  -p  dump PGM frames scaled by the given factor instead\n"
+            "  -t  write the SPI traffic to a text file\n",
+            name, SIM_DEFAULT_RUN_MS, SNAKE_DEFAULT_SEED);
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief Presses the scripted keys while the core sleeps or the MCU is
+ * in Stop mode.
+ *
+ * @return Non zero at the end of the run.
+ */
+int sim_stop_hook(void) {
+    sim_apply_events();
+    return sim_time_us() / 1000 >= run_ms;
+}
+
+/**
+ * @brief Dumps the display image after each screen update.
+ */
+void nokia5110_update_cplt_callback(void) {
+    char path[512];
+    nokia5110_stats_t stats;
+
+    nokia5110_get_stats(&stats);
+    frame_bursts += stats.bursts;
+    frame_segments += stats.segments;
+
+    frame_nr++;
+    if (frame_dir == NULL) {
+        return;
+    }
+
+    if (frame_scale != 0) {
+        snprintf(path, sizeof(path), "%s/frame_%05u.pgm", frame_dir, frame_nr);
+        sim_lcd_write_pgm(path, frame_scale);
+    } else {
+        snprintf(path, sizeof(path), "%s/frame_%05u.pbm", frame_dir, frame_nr);
+        sim_lcd_write_pbm(path);
+    }
+}
+
+/**
+ * @brief Main function.
+ */
+int main(int argc, char* argv[]) {
+    const char* script = NULL;
+    const char* trace = NULL;
+    const char* replay_in = NULL;
+    const char* replay_out = NULL;
+    uint32_t seed = 0;
+    uint32_t food_seed = SNAKE_DEFAULT_SEED;
+    uint8_t autoplay = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:i:r:s:l:w:ao:p:t:h")) != -1) {
+        switch (opt) {
+            case 'n': run_ms = strtoul(optarg, NULL, 0); break;
+            case 'i': script = optarg; break;
+            case 'r': seed = strtoul(optarg, NULL, 0); break;
+            case 's': food_seed = strtoul(optarg, NULL, 0); break;
+            case 'l': replay_in = optarg; break;
+            case 'w': replay_out = optarg; break;
+            case 'a': autoplay = 1; break;
+            case 'o': frame_dir = optarg; break;
+            case 'p': frame_scale = strtoul(optarg, NULL, 0); break;
+            case 't': trace = optarg; break;
+            default:
+                sim_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (script != NULL) {
+        if (sim_load_script(script) != 0) {
+            fprintf(stderr, "sim: can't read %s\n", script);
+            return EXIT_FAILURE;
+        }
+    } else if (seed != 0) {
+        sim_random_script(seed, run_ms);
+    }
+
+    sim_reset();
+    HAL_Init();
+    profile_init();
+    power_init(sim_clock_config);
+    keyboard_init();
+
+    if (replay_in != NULL) {
+        if (sim_load_replay(replay_in) != 0) {
+            fprintf(stderr, "sim: can't play %s\n", replay_in);
+            return EXIT_FAILURE;
+        }
+    } else {
+        replay_record(food_seed);
+    }
+
+    replay_status_t replay;
+    replay_get_status(&replay);
+
+    nokia5110_setup();
+    autopilot_init(&pilot);
+    game.input_context = &pilot;
+    // The board may not cover the whole display
+    nokia5110_clear_buffer();
+    snake_seed(&game, replay.seed);
+    snake_init(&game);
+    scheduler_init(SCHEDULER_STEP_HZ);
+
+    // Same loop as the firmware, the sleep moves to the next base tick
+    while (sim_time_us() / 1000 < run_ms) {
+        sim_apply_events();
+
+        // The run may end while sleeping up to the tick
+        scheduler_wait();
+        if (sim_time_us() / 1000 > run_ms) {
+            break;
+        }
+        keyboard_poll();
+        if (scheduler_step_due() != 0) {
+            snake_step(&game, (autoplay != 0) ? autopilot_input : replay_input);
+        }
+
+        __disable_irq();
+        if (autoplay == 0 && snake_is_idle(&game) != 0 && keyboard_is_idle() != 0 &&
+            replay_is_playing() == 0 && nokia5110_is_busy() == 0) {
+            power_stop();
+        }
+        __enable_irq();
+    }
+
+    size_t cmd_bytes = 0;
+    const sim_spi_record_t* records = sim_spi_records();
+    for (size_t i = 0; i < sim_spi_record_count(); i++) {
+        cmd_bytes += (records[i].dc == 0);
+    }
+
+    printf("simulated %u ms, %u screen updates\n", run_ms, frame_nr);
+    printf("spi: %zu bytes (%zu command, %zu data)\n",
+           sim_spi_record_count(), cmd_bytes, sim_spi_record_count() - cmd_bytes);
+    printf("screen updates: %u bursts, %u segments\n", frame_bursts, frame_segments);
+
+    scheduler_stats_t stats;
+    scheduler_get_stats(&stats);
+    printf("scheduler: %u steps, %u overruns, latency %u-%u us\n",
+           stats.steps, stats.overruns, stats.latency_min_us, stats.latency_max_us);
+
+    power_stats_t power;
+    power_get_stats(&power);
+    printf("power: run %u ms, sleep %u ms, stop %u ms (%u stops, clock restore %u us, max %u us)\n",
+           power.time_ms[POWER_RUN], power.time_ms[POWER_SLEEP], power.time_ms[POWER_STOP],
+           power.stops, power.clock_restore_us, power.clock_restore_max_us);
+    printf("keyboard: %u presses dropped\n", keyboard_dropped());
+
+    replay_get_status(&replay);
+    printf("replay: %u games, %u keys, %u bytes, %u not recorded%s\n",
+           replay.games, replay.events, replay.size, replay.overflow, replay.done ? ", done" : "");
+
+    if (autoplay != 0) {
+        autopilot_stats_t stats;
+
+        autopilot_get_stats(&pilot, &stats);
+        printf("autopilot: %u decisions, %u shortcuts, %u with no path, %u cells searched at most, size %u\n",
+               stats.decisions, stats.shortcuts, stats.no_path, stats.visited_max, game.size);
+    }
+
+    profile_dump();
+
+    if (replay_out != NULL && sim_write_replay(replay_out) != 0) {
+        fprintf(stderr, "sim: can't write %s\n", replay_out);
+        return EXIT_FAILURE;
+    }
+
+    if (trace != NULL && sim_write_trace(trace) != 0) {
+        fprintf(stderr, "sim: can't write %s\n", trace);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Generates a key bounce trace for the debounce test (sim/traces).
+
+Plays random presses and releases of the four keys (PB12 to PB15), each
+edge bouncing as measured on tactile switches: most contacts settle in
+0.2 to 3 ms, some take up to 10 ms, toggling every 20 to 300 us
+meanwhile. Some presses are chords, the second key following the first
+within 2 ms. The levels are sampled every KEYBOARD_SAMPLE_MS, at a
+random phase, like keyboard_poll does.
+
+The expected levels come from a per key reference counter: a level
+changes after DEBOUNCE_SAMPLES samples in a row that differ from it.
+The script also checks each physical press is debounced into one
+press, and prints the press count in the trace header.
+
+Usage: tools/gen_bounce_trace.py [-s seed] [-t seconds] [-o sim/traces/bounce_model.trace]
+"""
+import argparse
+import random
+import sys
+
+# See keyboard.h and debounce.h
+KEYS_NR = 4
+KEYBOARD_SAMPLE_MS = 5
+DEBOUNCE_SAMPLES = 4
+
+# Bounce model, in microseconds
+BOUNCE_SHORT_US = (200, 3000)
+BOUNCE_LONG_US = (3000, 10000)
+BOUNCE_LONG_SHARE = 0.2
+BOUNCE_TOGGLE_US = (20, 300)
+CHORD_SHARE = 0.2
+CHORD_DELAY_US = (0, 2000)
+
+# Press lengths and gaps, in microseconds
+HOLD_US = (40000, 400000)
+GAP_US = (40000, 1000000)
+
+
+def bounce(rng, edges, time_us, level):
+    """Adds the contact edges of a key going to level at time_us."""
+    span = BOUNCE_LONG_US if rng.random() < BOUNCE_LONG_SHARE else BOUNCE_SHORT_US
+    end_us = time_us + rng.randint(*span)
+    contact = level
+    while time_us < end_us:
+        edges.append((time_us, contact))
+        contact ^= 1
+        time_us += rng.randint(*BOUNCE_TOGGLE_US)
+    edges.append((end_us, level))
+
+
+def key_edges(rng, duration_us, chord_starts):
+    """Contact edges and press count of a key, following the chord starts."""
+    edges = [(0, 0)]
+    presses = 0
+    time_us = rng.randint(*GAP_US)
+    while time_us + HOLD_US[1] + GAP_US[0] < duration_us:
+        if chord_starts and rng.random() < CHORD_SHARE:
+            start = [t for t in chord_starts if t > edges[-1][0] + GAP_US[0]]
+            if start:
+                time_us = start[0] + rng.randint(*CHORD_DELAY_US)
+        hold_us = rng.randint(*HOLD_US)
+        bounce(rng, edges, time_us, 1)
+        bounce(rng, edges, time_us + hold_us, 0)
+        presses += 1
+        time_us += hold_us + rng.randint(*GAP_US)
+    return edges, presses
+
+
+def level_at(edges, time_us):
+    level = 0
+    for edge_us, edge_level in edges:
+        if edge_us > time_us:
+            break
+        level = edge_level
+    return level
+
+
+def generate(seed, seconds):
+    rng = random.Random(seed)
+    duration_us = seconds * 1000000
+    keys = []
+    chord_starts = []
+    for key in range(KEYS_NR):
+        edges, presses = key_edges(rng, duration_us, chord_starts)
+        keys.append((edges, presses))
+        chord_starts = sorted(set(chord_starts + [t for t, level in edges[1:] if level == 1]))
+
+    # Reference debounce, one counter per key
+    state = [0] * KEYS_NR
+    count = [0] * KEYS_NR
+    accepted = [0] * KEYS_NR
+    lines = []
+    time_us = rng.randint(0, KEYBOARD_SAMPLE_MS * 1000 - 1)
+    while time_us < duration_us:
+        sample = 0
+        for key, (edges, _) in enumerate(keys):
+            level = level_at(edges, time_us)
+            sample |= level << key
+            if level == state[key]:
+                count[key] = 0
+                continue
+            count[key] += 1
+            if count[key] == DEBOUNCE_SAMPLES:
+                state[key] = level
+                count[key] = 0
+                accepted[key] += level
+        levels = sum(level << key for key, level in enumerate(state))
+        stable = int(all(c == 0 for c in count))
+        lines.append("%x %x %d" % (sample, levels, stable))
+        time_us += KEYBOARD_SAMPLE_MS * 1000
+
+    for key, (_, presses) in enumerate(keys):
+        if accepted[key] != presses:
+            sys.exit("key %d: %d presses debounced into %d" % (key, presses, accepted[key]))
+    return lines, [presses for _, presses in keys]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-s", "--seed", type=int, default=1, help="random seed (default 1)")
+    parser.add_argument("-t", "--time", type=int, default=30, help="trace length in seconds (default 30)")
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    args = parser.parse_args()
+
+    lines, presses = generate(args.seed, args.time)
+    out = open(args.output, "w") if args.output else sys.stdout
+    out.write("# Generated by tools/gen_bounce_trace.py -s %d -t %d\n" % (args.seed, args.time))
+    out.write("# %d s of bouncing keys sampled every %d ms, %s presses of each key\n"
+              % (args.time, KEYBOARD_SAMPLE_MS, "/".join(str(p) for p in presses)))
+    out.write("# sample state stable\n")
+    for line in lines:
+        out.write(line + "\n")
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Generates the snake cell lookup tables (core/inc/snake_lut.h).
+
+Each board cell is a square block of the Nokia 5110 screen_buffer. The
+buffer holds 84 columns by 6 lines of 8 vertical pixels, so a cell up to
+8 pixels tall covers the same columns of one or two lines. For each cell
+the tables give the buffer offset of its first column on the first line,
+from the board origin, and for each board line the pixel masks in the
+first and the second display line.
+
+The header holds the tables of each board given, the build picks the
+one matching SNAKE_MAX_X, SNAKE_MAX_Y and SNAKE_PART_SIZE (see snake.h).
+It always has the boards filling the display with 2, 4 and 8 pixel
+cells, and the boards given with -b after them.
+
+Usage: tools/gen_cell_lut.py [-b 20x11/4 ...] [-o core/inc/snake_lut.h]
+
+Prints the table sizes to stderr.
+"""
+import argparse
+import sys
+
+# First pixel of the cells, from the board origin, see snake.h
+X_0 = 2
+Y_0 = 2
+
+# Display geometry, see nokia5110.h
+COL_NR = 84
+LINE_NR = 6
+
+# Cell sizes handled by the game
+PART_SIZES = (2, 4, 8)
+
+
+class Board:
+    def __init__(self, max_x, max_y, part_size):
+        self.max_x = max_x
+        self.max_y = max_y
+        self.part_size = part_size
+
+    @classmethod
+    def filling(cls, part_size):
+        """Largest board of the given cell size fitting the display."""
+        return cls((COL_NR - 2 * X_0) // part_size, (LINE_NR * 8 - 2 * Y_0) // part_size, part_size)
+
+    @classmethod
+    def parse(cls, text):
+        """Board from a WIDTHxHEIGHT/PART_SIZE string."""
+        try:
+            size, part_size = text.split("/")
+            max_x, max_y = size.split("x")
+            return cls(int(max_x), int(max_y), int(part_size))
+        except ValueError:
+            raise argparse.ArgumentTypeError("expected WIDTHxHEIGHT/PART_SIZE, got %r" % text)
+
+    def __str__(self):
+        return "%dx%d/%d" % (self.max_x, self.max_y, self.part_size)
+
+    def cell_offset(self, x, y):
+        """Buffer offset of the first column of a cell on its first line."""
+        top = Y_0 + self.part_size * y
+        return (top // 8) * COL_NR + X_0 + self.part_size * x
+
+    def line_masks(self, y):
+        """Pixel masks of a board line in its first and second display line."""
+        top = Y_0 + self.part_size * y
+        mask = ((1 << self.part_size) - 1) << (top % 8)
+        return mask & 0xFF, mask >> 8
+
+    def check(self):
+        if self.part_size not in PART_SIZES:
+            sys.exit("%s: the cell size must be one of %s" % (self, PART_SIZES))
+        if 2 * X_0 + self.part_size * self.max_x > COL_NR or 2 * Y_0 + self.part_size * self.max_y > LINE_NR * 8:
+            sys.exit("%s: the board doesn't fit in the display" % self)
+
+
+def emit_board(w, board):
+    offsets = [board.cell_offset(x, y) for y in range(board.max_y) for x in range(board.max_x)]
+    masks = [board.line_masks(y) for y in range(board.max_y)]
+
+    w("#if (SNAKE_MAX_X == %d) && (SNAKE_MAX_Y == %d) && (SNAKE_PART_SIZE == %d)\n\n"
+      % (board.max_x, board.max_y, board.part_size))
+    w("/** Board geometry of the tables. */\n")
+    w("#define SNAKE_LUT_MAX_X         %d\n" % board.max_x)
+    w("#define SNAKE_LUT_MAX_Y         %d\n" % board.max_y)
+    w("#define SNAKE_LUT_PART_SIZE     %d\n" % board.part_size)
+    w("#define SNAKE_LUT_X_0           %d\n" % X_0)
+    w("#define SNAKE_LUT_Y_0           %d\n\n" % Y_0)
+
+    w("// screen_buffer offset of each cell, by cell index, from the board origin\n")
+    w("static const uint16_t snake_lut_offset[SNAKE_LUT_MAX_X * SNAKE_LUT_MAX_Y] = {\n")
+    for y in range(board.max_y):
+        row = offsets[y * board.max_x:(y + 1) * board.max_x]
+        for i in range(0, len(row), 20):
+            w("    " + ", ".join("%3d" % o for o in row[i:i + 20]) + ",\n")
+    w("};\n\n")
+
+    w("// Pixel masks of each board line in its first and second display line\n")
+    w("static const uint8_t snake_lut_mask[SNAKE_LUT_MAX_Y][2] = {\n")
+    for low, high in masks:
+        w("    { 0x%02X, 0x%02X },\n" % (low, high))
+    w("};\n\n")
+    w("#endif\n\n")
+
+    sys.stderr.write("%s: snake_lut_offset %d bytes, snake_lut_mask %d bytes\n"
+                     % (board, 2 * len(offsets), 2 * len(masks)))
+
+
+def emit(out, boards):
+    w = out.write
+    w("/**\n")
+    w(" * @file\n")
+    w(" * @ingroup snake\n")
+    w(" * @brief Cell lookup tables, generated by tools/gen_cell_lut.py.\n")
+    w(" *\n")
+    w(" * Do not edit, run the script again after changing the board geometry.\n")
+    w(" * Only included by snake.c (and bench.c), after snake.h, which sets the\n")
+    w(" * board geometry picking the tables.\n")
+    w(" */\n")
+    w("#ifndef SNAKE_LUT_H\n")
+    w("#define SNAKE_LUT_H\n\n")
+    w("#include \"snake.h\"\n\n")
+    w("#include <stdint.h>\n\n")
+    for board in boards:
+        emit_board(w, board)
+    w("#endif /* SNAKE_LUT_H */\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-b", "--board", action="append", type=Board.parse,
+                        help="extra board as WIDTHxHEIGHT/PART_SIZE, repeat for more (always has %s)"
+                        % ", ".join(str(Board.filling(size)) for size in PART_SIZES))
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    args = parser.parse_args()
+
+    boards = []
+    for board in [Board.filling(size) for size in PART_SIZES] + (args.board or []):
+        board.check()
+        if str(board) not in [str(other) for other in boards]:
+            boards.append(board)
+    if args.output:
+        with open(args.output, "w") as out:
+            emit(out, boards)
+    else:
+        emit(sys.stdout, boards)
+
+
+if __name__ == "__main__":
+    main()